@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "message.h"
+
+// Standby altimeter drums -> AltimeterMessage, read by the hub from what DCS-BIOS exports, and
+// the integer helpers the altimeter gauge draws it with. The drums are geared to the needle, so
+// each one reads as a digit plus the fraction the drum below it has turned; the digit is that
+// reading less the fraction, rounded. All arithmetic is in 1/65536 of a digit, which is also
+// what one turn of the needle is worth on the 1000s drum.
+static const int32_t altitudeScale = 16;                        // AltimeterMessage::altitude per foot
+static const int32_t altitudePerTurn = 1000 * altitudeScale;    // one turn of the needle
+static const int32_t altitudeRange = 100000 * altitudeScale;    // where the 10000s drum goes round
+
+// Raw DCS-BIOS values, kept by the hub only
+struct AltimeterDrums {
+  uint16_t alt100FtPtr;
+  uint16_t alt1000FtCnt;
+  uint16_t alt10000FtCnt; // 0-9 over 0-65535, not 0-10 like the others
+  uint16_t pressSet0;     // Kollsman ones
+  uint16_t pressSet1;     // Kollsman tens
+  uint16_t pressSet2;     // Kollsman thousands and hundreds, 28-31 in four steps
+};
+
+// `reading` and `below` in 1/65536 of a digit
+static inline int32_t drumDigit(int32_t reading, int32_t below) {
+  return (((reading - below + 32768) >> 16) % 10 + 10) % 10;
+}
+
+static inline int32_t altimeterAltitude(const AltimeterDrums& d) {
+  const int32_t needle = d.alt100FtPtr;
+  const int32_t thousands = drumDigit((int32_t)d.alt1000FtCnt * 10, needle);
+  const int32_t tenThousands = drumDigit((int32_t)d.alt10000FtCnt * 9, (thousands * 65536 + needle) / 10);
+  int32_t altitude = (tenThousands * 10 + thousands) * altitudePerTurn + needle * altitudePerTurn / 65536;
+  // Below sea level the drums roll back past zero and read 9x,xxx ft
+  if (tenThousands == 9) {
+    altitude -= altitudeRange;
+  }
+  return altitude;
+}
+
+// Hundredths of an inch of mercury, 2992 for 29.92
+static inline uint16_t altimeterKollsman(const AltimeterDrums& d) {
+  const int32_t ones = drumDigit((int32_t)d.pressSet0 * 10, 0);
+  const int32_t tens = drumDigit((int32_t)d.pressSet1 * 10, (int32_t)d.pressSet0);
+  const int32_t high = d.pressSet2 < 39321 ? 28 : d.pressSet2 < 52428 ? 29 : d.pressSet2 < 65535 ? 30 : 31;
+  return (uint16_t)(high * 100 + tens * 10 + ones);
+}
+
+static inline void encodeAltimeter(const AltimeterDrums& d, AltimeterMessage& m) {
+  m.altitude = altimeterAltitude(d);
+  m.kollsman = altimeterKollsman(d);
+}
+
+// Gauge side, `altitude` as in AltimeterMessage
+static inline int32_t altitudeModulo(int32_t altitude, int32_t range) {
+  return (altitude % range + range) % range;
+}
+
+// Tenths of a degree
+static inline int32_t altimeterNeedleAngle(int32_t altitude) {
+  return altitudeModulo(altitude, altitudePerTurn) * 3600 / altitudePerTurn;
+}
+
+// How far the 1000s and 10000s drums have turned, in 1/digitHeight of a digit from 0
+static inline int32_t altimeterThousandsDrum(int32_t altitude, int32_t digitHeight) {
+  return altitudeModulo(altitude, 10 * altitudePerTurn) * digitHeight / altitudePerTurn;
+}
+
+static inline int32_t altimeterTenThousandsDrum(int32_t altitude, int32_t digitHeight) {
+  return altitudeModulo(altitude, altitudeRange) * digitHeight / (10 * altitudePerTurn);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "message.h"
+
+// SaiMessage -> AttitudeMessage against the last full SaiMessage, encoded by the hub and decoded
+// by the SARI. The shift is the smallest that fits all three deltas in an int8_t, so small
+// motions keep full resolution and fast ones trade it for range; deltas are always taken from
+// the base, so quantization error never accumulates. When a field other than pitch, bank or the
+// slip ball changed, or the deltas need more than attitudeMaxShift, encodeAttitude() fails and
+// the hub sends a full SaiMessage, which becomes the new base.
+static const uint8_t attitudeMaxShift = 6; // 64 raw units, about 0.35 degrees of bank
+
+static inline uint16_t attitudeBase(const SaiMessage& base) {
+  return (uint16_t)base.header.ms;
+}
+
+// Bank wraps around, the 16 bit difference is taken modulo 2^16 for all three
+static inline int32_t attitudeDelta(uint16_t from, uint16_t to) {
+  return (int16_t)(uint16_t)(to - from);
+}
+
+static inline bool encodeAttitude(const SaiMessage& base, const SaiMessage& to, AttitudeMessage& m) {
+  if (to.rateOfTurn != base.rateOfTurn || to.manPitchAdj != base.manPitchAdj ||
+      to.attWarningFlag != base.attWarningFlag || to.pointerHor != base.pointerHor ||
+      to.pointerVer != base.pointerVer) {
+    return false;
+  }
+  const int32_t pitch = attitudeDelta(base.pitch, to.pitch);
+  const int32_t bank = attitudeDelta(base.bank, to.bank);
+  const int32_t slipBall = attitudeDelta(base.slipBall, to.slipBall);
+  for (uint8_t shift = 0; shift <= attitudeMaxShift; shift++) {
+    const int32_t half = shift ? 1 << (shift - 1) : 0;
+    const int32_t p = (pitch + half) >> shift;
+    const int32_t b = (bank + half) >> shift;
+    const int32_t s = (slipBall + half) >> shift;
+    if (p >= -128 && p <= 127 && b >= -128 && b <= 127 && s >= -128 && s <= 127) {
+      m.baseMs = attitudeBase(base);
+      m.shift = shift;
+      m.pitch = (int8_t)p;
+      m.bank = (int8_t)b;
+      m.slipBall = (int8_t)s;
+      return true;
+    }
+  }
+  return false;
+}
+
+// False when `base` is not the SaiMessage the deltas were taken from
+static inline bool decodeAttitude(const AttitudeMessage& m, const SaiMessage& base, SaiMessage& to) {
+  if (m.baseMs != attitudeBase(base) || m.shift > attitudeMaxShift) {
+    return false;
+  }
+  to = base;
+  to.header = m.header;
+  to.header.category = MessageCategory::SAI;
+  to.pitch = (uint16_t)(base.pitch + (m.pitch * (1 << m.shift)));
+  to.bank = (uint16_t)(base.bank + (m.bank * (1 << m.shift)));
+  to.slipBall = (uint16_t)(base.slipBall + (m.slipBall * (1 << m.shift)));
+  return true;
+}
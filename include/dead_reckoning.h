@@ -0,0 +1,86 @@
+#pragma once
+
+#include <Arduino.h>
+#include <cstring>
+#include "message.h"
+
+// Moves a needle between frames from the last value and the rate the hub sent for it
+// (TrendMessage). Extrapolation stops deadReckoningHorizon after the last value, so after a lost
+// frame the needle holds instead of running away; the next value puts it back on track.
+static const uint32_t deadReckoningHorizon = 120; // ms, about four frames at the hub's rate
+
+class DeadReckoner {
+public:
+  // Wrapping values (the bank) go round instead of stopping at the ends
+  explicit DeadReckoner(uint16_t initial = 0, bool wraps = false) : DeadReckoner(initial, 0, 65535, wraps) {}
+  // Values with another range, the altitude
+  DeadReckoner(int32_t initial, int32_t low, int32_t high, bool wraps = false)
+    : position(initial), low(low), high(high), wraps(wraps), value(initial) {}
+
+  void onValue(int32_t v, uint32_t now) {
+    value = v;
+    valueAt = now;
+  }
+
+  void onRate(int16_t r) {
+    rate = r;
+  }
+
+  int32_t at(uint32_t now) const {
+    const uint32_t elapsed = now - valueAt < deadReckoningHorizon ? now - valueAt : deadReckoningHorizon;
+    const int32_t v = value + (int32_t)rate * (int32_t)elapsed / 1000;
+    if (wraps) {
+      const int32_t range = high - low + 1;
+      return low + ((v - low) % range + range) % range;
+    }
+    return constrain(v, low, high);
+  }
+
+  // Position to render now, true when it differs from the one returned last time
+  bool update(uint32_t now) {
+    const int32_t p = at(now);
+    const bool moved = p != position;
+    position = p;
+    return moved;
+  }
+
+  int32_t position;
+
+private:
+  int32_t low;
+  int32_t high;
+  bool wraps;
+  int32_t value;
+  uint32_t valueAt = 0;
+  int16_t rate = 0;
+};
+
+// Calls fn(TrendField, int16_t rate) for each rate in a TrendMessage of `len` bytes
+template<typename F>
+static inline bool forEachTrend(const uint8_t* data, int len, F fn) {
+  constexpr int ratesOffset = offsetof(TrendMessage, rates);
+  if (len < ratesOffset) {
+    return false;
+  }
+  const uint8_t fields = data[offsetof(TrendMessage, fields)];
+  int expected = ratesOffset;
+  for (size_t i = 0; i < trendFieldCount; i++) {
+    if (fields & (1u << i)) {
+      expected += sizeof(int16_t);
+    }
+  }
+  if (expected != len) {
+    return false;
+  }
+
+  const uint8_t* p = data + ratesOffset;
+  for (size_t i = 0; i < trendFieldCount; i++) {
+    if (fields & (1u << i)) {
+      int16_t rate;
+      std::memcpy(&rate, p, sizeof(rate));
+      p += sizeof(rate);
+      fn(static_cast<TrendField>(i), rate);
+    }
+  }
+  return true;
+}
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <Arduino.h>
+#include <cstring>
+#include "message.h"
+
+// Parity for the broadcast streams that have no retransmission (SAI, altimeter): after every
+// HUB_FEC_GROUP records of a protected category, or fecGroupTimeout after the first, the hub
+// sends a ParityMessage with their XOR. A gauge that received all but one of them rebuilds the
+// missing record right away instead of waiting for the next update; it is applied only when
+// nothing newer has arrived. Records of one category have a fixed size, so the XOR covers them
+// whole, header included. The cost is one parity record per group, about 1/HUB_FEC_GROUP of
+// the stream's airtime. The attitude stream is not protected: its deltas are superseded by the
+// next export frame, long before a group's parity could rebuild one.
+#ifndef HUB_FEC_GROUP
+  #define HUB_FEC_GROUP 4 // records per parity, 0 sends none
+#endif
+
+static const uint8_t fecGroupSize = HUB_FEC_GROUP;
+static const uint8_t fecMaxGroup = 16; // records a gauge keeps per category
+static const size_t fecMaxRecordSize = sizeof(ParityMessage::parity);
+static const size_t fecProtectedCount = 2;
+// A group also closes this long after its first record, so the full SaiMessages, which mostly
+// go out once per resync, get their parity while it can still help
+static const uint32_t fecGroupTimeout = 100; // ms, about three altimeter records
+static_assert(fecGroupSize <= fecMaxGroup, "HUB_FEC_GROUP: gauges keep at most fecMaxGroup records");
+static_assert(sizeof(AltimeterMessage) <= fecMaxRecordSize, "ParityMessage::parity is too short");
+
+// Slot of a protected category, -1 for the others
+static inline int fecIndex(MessageCategory category) {
+  switch (category) {
+  case MessageCategory::SAI: return 0;
+  case MessageCategory::Altimeter: return 1;
+  default: return -1;
+  }
+}
+
+static inline size_t parityLength(size_t recordLen) {
+  return offsetof(ParityMessage, parity) + recordLen;
+}
+
+// Hub side: fed every protected record that went out, in seq order
+class ParityEncoder {
+public:
+  // True when `record` completed a group, `m` then holds its parity
+  bool add(const uint8_t* record, size_t len, uint32_t now, ParityMessage& m, size_t& mLen) {
+    const MessageHeader* h = reinterpret_cast<const MessageHeader*>(record);
+    const int index = fecIndex(h->category);
+    if (fecGroupSize == 0 || index < 0 || len > fecMaxRecordSize) {
+      return false;
+    }
+    Group& g = groups[index];
+    if (g.count > 0 && (len != g.len || h->seq != (uint8_t)(g.firstSeq + g.count))) {
+      g.count = 0; // a different layout or a seq that was not ours, start over
+    }
+    if (g.count == 0) {
+      g.firstSeq = h->seq;
+      g.len = (uint8_t)len;
+      g.startedAt = now;
+      memset(g.parity, 0, sizeof(g.parity));
+    }
+    for (size_t i = 0; i < len; i++) {
+      g.parity[i] ^= record[i];
+    }
+    if (++g.count < fecGroupSize) {
+      return false;
+    }
+    close(static_cast<MessageCategory>(h->category), g, now, m, mLen);
+    return true;
+  }
+
+  // True when a group ran past fecGroupTimeout, `m` then holds the parity of what it has
+  bool expire(uint32_t now, ParityMessage& m, size_t& mLen) {
+    for (size_t i = 0; i < messageCategoryCount; i++) {
+      const int index = fecIndex(static_cast<MessageCategory>(i));
+      if (index >= 0 && groups[index].count > 0 && now - groups[index].startedAt >= fecGroupTimeout) {
+        close(static_cast<MessageCategory>(i), groups[index], now, m, mLen);
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  struct Group {
+    uint32_t startedAt;
+    uint8_t firstSeq;
+    uint8_t count;
+    uint8_t len;
+    uint8_t parity[fecMaxRecordSize];
+  };
+
+  static void close(MessageCategory category, Group& g, uint32_t now, ParityMessage& m, size_t& mLen) {
+    m = ParityMessage{};
+    m.header.ms = now;
+    m.protects = category;
+    m.firstSeq = g.firstSeq;
+    m.count = g.count;
+    memcpy(m.parity, g.parity, g.len);
+    mLen = parityLength(g.len);
+    g.count = 0;
+  }
+
+  Group groups[fecProtectedCount]{};
+};
+
+// Gauge side: keeps the last records of each protected category and rebuilds a lost one when
+// its group's parity arrives. Call recordFrame() for every frame received, before the frame's
+// own records are handled.
+class FecReceiver {
+public:
+  // A rebuilt record that is newer than any received goes to handler(data, len)
+  template<typename Handler>
+  void recordFrame(const uint8_t* data, int len, Handler handler) {
+    forEachMessage(data, len, [this, &handler](const uint8_t* message, int messageLen) {
+      const MessageHeader* h = reinterpret_cast<const MessageHeader*>(message);
+      if (h->category == MessageCategory::Parity) {
+        onParity(message, messageLen, handler);
+      } else if (fecIndex(h->category) >= 0) {
+        keep(message, messageLen);
+      }
+    });
+  }
+
+  void print(Print& out) const {
+    for (size_t i = 0; i < messageCategoryCount; i++) {
+      const int index = fecIndex(static_cast<MessageCategory>(i));
+      if (index < 0 || !streams[index].seen) {
+        continue;
+      }
+      const Stream& s = streams[index];
+      out.printf("%-14s %u rebuilt from parity (%u applied, the rest outdated), %u unrecoverable\n",
+                 categoryName(static_cast<MessageCategory>(i)), (unsigned)s.recovered, (unsigned)s.applied,
+                 (unsigned)s.unrecoverable);
+    }
+  }
+
+private:
+  struct Stream {
+    uint8_t records[fecMaxGroup][fecMaxRecordSize];
+    uint8_t lens[fecMaxGroup]; // 0 for an empty slot
+    uint8_t newestSeq;
+    bool seen;
+    uint32_t recovered;
+    uint32_t applied;
+    uint32_t unrecoverable; // records lost in a group that lost more than one
+  };
+
+  // Stored at seq % fecMaxGroup, the record's own header tells which seq a slot holds
+  static bool holds(const Stream& s, uint8_t seq, size_t len) {
+    const uint8_t slot = seq % fecMaxGroup;
+    return s.lens[slot] == len && reinterpret_cast<const MessageHeader*>(s.records[slot])->seq == seq;
+  }
+
+  void keep(const uint8_t* message, int len) {
+    if (len > (int)fecMaxRecordSize) {
+      return;
+    }
+    const MessageHeader* h = reinterpret_cast<const MessageHeader*>(message);
+    Stream& s = streams[fecIndex(h->category)];
+    const uint8_t slot = h->seq % fecMaxGroup;
+    memcpy(s.records[slot], message, len);
+    s.lens[slot] = (uint8_t)len;
+    if (!s.seen || (int8_t)(h->seq - s.newestSeq) > 0) {
+      s.newestSeq = h->seq;
+      s.seen = true;
+    }
+  }
+
+  template<typename Handler>
+  void onParity(const uint8_t* message, int len, Handler& handler) {
+    const ParityMessage* p = reinterpret_cast<const ParityMessage*>(message);
+    const int recordLen = len - (int)offsetof(ParityMessage, parity);
+    const int index = len > (int)offsetof(ParityMessage, parity) ? fecIndex(p->protects) : -1;
+    if (index < 0 || recordLen < (int)sizeof(MessageHeader) || recordLen > (int)fecMaxRecordSize ||
+        p->count == 0 || p->count > fecMaxGroup) {
+      return;
+    }
+    Stream& s = streams[index];
+
+    uint8_t missing = 0;
+    uint8_t missingSeq = 0;
+    for (uint8_t i = 0; i < p->count; i++) {
+      const uint8_t seq = p->firstSeq + i;
+      if (!holds(s, seq, recordLen)) {
+        missing++;
+        missingSeq = seq;
+      }
+    }
+    if (missing == 0) {
+      return;
+    }
+    if (missing > 1) {
+      s.unrecoverable += missing;
+      return;
+    }
+
+    uint8_t rebuilt[fecMaxRecordSize];
+    memcpy(rebuilt, p->parity, recordLen);
+    for (uint8_t i = 0; i < p->count; i++) {
+      const uint8_t seq = p->firstSeq + i;
+      if (seq == missingSeq) {
+        continue;
+      }
+      const uint8_t* record = s.records[seq % fecMaxGroup];
+      for (int j = 0; j < recordLen; j++) {
+        rebuilt[j] ^= record[j];
+      }
+    }
+    const MessageHeader* h = reinterpret_cast<const MessageHeader*>(rebuilt);
+    if (h->category != p->protects || h->seq != missingSeq || h->schema != messageSchema) {
+      s.unrecoverable++;
+      return;
+    }
+    s.recovered++;
+    const bool newer = !s.seen || (int8_t)(missingSeq - s.newestSeq) > 0;
+    keep(rebuilt, recordLen);
+    if (newer) {
+      s.applied++;
+      handler(rebuilt, recordLen);
+    }
+  }
+
+  Stream streams[fecProtectedCount]{};
+};
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+// Frame log: FRAME_LOG_MAGIC followed by append-only records, little endian:
+// [FrameLogRecord][len bytes of the frame exactly as it was sent]. The destination is not
+// kept, unicast frames to subscribed gauges are logged like broadcasts.
+#define FRAME_LOG_MAGIC "HFL1"
+#define FRAME_LOG_MAGIC_SIZE 4
+
+struct __attribute__((packed)) FrameLogRecord {
+  uint32_t ms;  // hub millis() when the frame was sent
+  uint8_t len;
+};
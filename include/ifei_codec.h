@@ -0,0 +1,217 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "message.h"
+
+// IfeiMessage <-> IfeiCompactMessage, encoded by the hub and decoded by the IFEI display.
+// Anything the compact layout cannot hold makes encodeIfeiCompact() fail, the hub then sends
+// the full IfeiMessage instead.
+
+// Textures as bits of IfeiCompactMessage::textures. l0Tex, l50Tex, r0Tex, r50Tex and nozTex are
+// not exported by DCS-BIOS and always decode as 0.
+static constexpr uint8_t ifeiTextureFields[] = {
+  offsetof(IfeiMessage, bingoTex), offsetof(IfeiMessage, ffTex),
+  offsetof(IfeiMessage, lTex), offsetof(IfeiMessage, l100Tex), offsetof(IfeiMessage, lPointerTex), offsetof(IfeiMessage, lScaleTex),
+  offsetof(IfeiMessage, rTex), offsetof(IfeiMessage, r100Tex), offsetof(IfeiMessage, rPointerTex), offsetof(IfeiMessage, rScaleTex),
+  offsetof(IfeiMessage, oilTex), offsetof(IfeiMessage, rpmTex), offsetof(IfeiMessage, tempTex), offsetof(IfeiMessage, zTex),
+};
+static constexpr size_t ifeiTextureCount = sizeof(ifeiTextureFields) / sizeof(ifeiTextureFields[0]);
+static_assert(ifeiTextureCount <= 16, "IfeiCompactMessage::textures has one bit per texture");
+
+// Numbers as right aligned BCD with leading blanks, -1 (nothing shown) is all blanks
+struct IfeiDigitField {
+  uint8_t offset;
+  uint8_t size;   // int8_t or int16_t
+  uint8_t digits;
+};
+
+#define IFEI_DIGITS(name, digits) IfeiDigitField{ offsetof(IfeiMessage, name), sizeof(IfeiMessage::name), digits }
+
+static constexpr IfeiDigitField ifeiDigitFields[] = {
+  IFEI_DIGITS(rpmL, 3), IFEI_DIGITS(rpmR, 3),
+  IFEI_DIGITS(tempL, 3), IFEI_DIGITS(tempR, 3),
+  IFEI_DIGITS(ffL, 3), IFEI_DIGITS(ffR, 3),
+  IFEI_DIGITS(oilPressL, 3), IFEI_DIGITS(oilPressR, 3),
+  IFEI_DIGITS(bingo, 5),
+  IFEI_DIGITS(clockH, 2), IFEI_DIGITS(clockM, 2), IFEI_DIGITS(clockS, 2),
+  IFEI_DIGITS(timerH, 2), IFEI_DIGITS(timerM, 2), IFEI_DIGITS(timerS, 2),
+};
+#undef IFEI_DIGITS
+
+static constexpr uint8_t ifeiBlankDigit = 0xF;
+
+// Strings as 4 bit indexes into ifeiAlphabet, a 0 nibble ends a string shorter than its slot
+struct IfeiTextField {
+  uint8_t offset;
+  uint8_t length; // characters kept on air
+};
+
+#define IFEI_TEXT(name, length) IfeiTextField{ offsetof(IfeiMessage, name), length }
+
+static constexpr IfeiTextField ifeiTextFields[] = {
+  IFEI_TEXT(fuelUp, 6), IFEI_TEXT(fuelDown, 6), IFEI_TEXT(timeSetMode, 6), IFEI_TEXT(t, 6),
+  IFEI_TEXT(sp, 3), IFEI_TEXT(codes, 3),
+};
+#undef IFEI_TEXT
+
+static constexpr char ifeiAlphabet[16] = { '\0', ' ', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '.', ':', '-', 'T' };
+
+// dd1..dd4 as two bits each
+static constexpr char ifeiColons[4] = { '\0', ' ', ':', '.' };
+
+// Recursive so the ifei and sari envs (C++11) can evaluate them too
+static constexpr size_t ifeiDigitNibbles(size_t i = 0) {
+  return i < sizeof(ifeiDigitFields) / sizeof(ifeiDigitFields[0]) ? ifeiDigitFields[i].digits + ifeiDigitNibbles(i + 1) : 0;
+}
+
+static constexpr size_t ifeiTextNibbles(size_t i = 0) {
+  return i < sizeof(ifeiTextFields) / sizeof(ifeiTextFields[0]) ? ifeiTextFields[i].length + ifeiTextNibbles(i + 1) : 0;
+}
+
+static_assert((ifeiDigitNibbles() + 1) / 2 == sizeof(IfeiCompactMessage::digits), "IfeiCompactMessage::digits size");
+static_assert((ifeiTextNibbles() + 1) / 2 == sizeof(IfeiCompactMessage::text), "IfeiCompactMessage::text size");
+
+static inline void setIfeiNibble(uint8_t* bytes, size_t index, uint8_t value) {
+  uint8_t& b = bytes[index / 2];
+  b = index % 2 == 0 ? (uint8_t)((b & 0x0F) | (value << 4)) : (uint8_t)((b & 0xF0) | value);
+}
+
+static inline uint8_t getIfeiNibble(const uint8_t* bytes, size_t index) {
+  return index % 2 == 0 ? bytes[index / 2] >> 4 : bytes[index / 2] & 0x0F;
+}
+
+static inline int readIfeiNumber(const uint8_t* p, uint8_t size) {
+  if (size == 1) {
+    return (int8_t)p[0];
+  }
+  int16_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline void writeIfeiNumber(uint8_t* p, uint8_t size, int value) {
+  if (size == 1) {
+    p[0] = (uint8_t)(int8_t)value;
+    return;
+  }
+  const int16_t v = (int16_t)value;
+  std::memcpy(p, &v, sizeof(v));
+}
+
+static inline bool encodeIfeiCompact(const IfeiMessage& m, IfeiCompactMessage& c) {
+  const uint8_t* src = reinterpret_cast<const uint8_t*>(&m);
+  c.header.seq = m.header.seq;
+  c.header.ms = m.header.ms;
+
+  c.textures = 0;
+  for (size_t i = 0; i < ifeiTextureCount; i++) {
+    if (src[ifeiTextureFields[i]] == 1) {
+      c.textures |= 1u << i;
+    }
+  }
+
+  const uint8_t dd[4] = { m.dd1, m.dd2, m.dd3, m.dd4 };
+  c.colons = 0;
+  for (size_t i = 0; i < 4; i++) {
+    const char* found = (const char*)std::memchr(ifeiColons, dd[i], sizeof(ifeiColons));
+    if (!found) {
+      return false;
+    }
+    c.colons |= (uint8_t)((found - ifeiColons) << (i * 2));
+  }
+
+  if (m.colorMode > 0xFF) {
+    return false;
+  }
+  c.colorMode = (uint8_t)m.colorMode;
+  c.dispIntLt = m.dispIntLt;
+  c.extNozzlePosL = m.extNozzlePosL;
+  c.extNozzlePosR = m.extNozzlePosR;
+
+  std::memset(c.digits, 0xFF, sizeof(c.digits));
+  size_t nibble = 0;
+  for (const IfeiDigitField& f : ifeiDigitFields) {
+    int value = readIfeiNumber(src + f.offset, f.size);
+    if (value < -1) {
+      return false;
+    }
+    for (size_t d = f.digits; d-- > 0;) {
+      uint8_t digit = ifeiBlankDigit;
+      if (value >= 0 && (value > 0 || d == f.digits - 1u)) {
+        digit = value % 10;
+        value /= 10;
+      }
+      setIfeiNibble(c.digits, nibble + d, digit);
+    }
+    if (value > 0) {
+      return false; // more digits than the display has
+    }
+    nibble += f.digits;
+  }
+
+  std::memset(c.text, 0, sizeof(c.text));
+  nibble = 0;
+  for (const IfeiTextField& f : ifeiTextFields) {
+    const char* s = reinterpret_cast<const char*>(src + f.offset);
+    if (strnlen(s, f.length + 1) > f.length) {
+      return false;
+    }
+    for (size_t i = 0; i < f.length && s[i] != '\0'; i++) {
+      const char* found = (const char*)std::memchr(ifeiAlphabet + 1, s[i], sizeof(ifeiAlphabet) - 1);
+      if (!found) {
+        return false;
+      }
+      setIfeiNibble(c.text, nibble + i, (uint8_t)(found - ifeiAlphabet));
+    }
+    nibble += f.length;
+  }
+  return true;
+}
+
+static inline void decodeIfeiCompact(const IfeiCompactMessage& c, IfeiMessage& m) {
+  m = IfeiMessage{};
+  uint8_t* dst = reinterpret_cast<uint8_t*>(&m);
+  m.header.seq = c.header.seq;
+  m.header.ms = c.header.ms;
+
+  for (size_t i = 0; i < ifeiTextureCount; i++) {
+    dst[ifeiTextureFields[i]] = (c.textures >> i) & 1;
+  }
+
+  m.dd1 = ifeiColons[c.colons & 3];
+  m.dd2 = ifeiColons[(c.colons >> 2) & 3];
+  m.dd3 = ifeiColons[(c.colons >> 4) & 3];
+  m.dd4 = ifeiColons[(c.colons >> 6) & 3];
+
+  m.colorMode = c.colorMode;
+  m.dispIntLt = c.dispIntLt;
+  m.extNozzlePosL = c.extNozzlePosL;
+  m.extNozzlePosR = c.extNozzlePosR;
+
+  size_t nibble = 0;
+  for (const IfeiDigitField& f : ifeiDigitFields) {
+    int value = -1;
+    for (size_t d = 0; d < f.digits; d++) {
+      const uint8_t digit = getIfeiNibble(c.digits, nibble + d);
+      if (digit <= 9) {
+        value = (value < 0 ? 0 : value * 10) + digit;
+      }
+    }
+    writeIfeiNumber(dst + f.offset, f.size, value);
+    nibble += f.digits;
+  }
+
+  nibble = 0;
+  for (const IfeiTextField& f : ifeiTextFields) {
+    char* s = reinterpret_cast<char*>(dst + f.offset);
+    for (size_t i = 0; i < f.length; i++) {
+      s[i] = ifeiAlphabet[getIfeiNibble(c.text, nibble + i)];
+      if (s[i] == '\0') {
+        break;
+      }
+    }
+    nibble += f.length;
+  }
+}
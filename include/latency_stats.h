@@ -0,0 +1,215 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "message.h"
+#include "transport.h"
+
+// Hub-to-gauge transit and receive-to-display latency. The hub stamps MessageHeader::ms from its
+// millis(), ClockSync estimates the offset between the two clocks so a gauge can tell how long a
+// frame was on the way. Call recordFrame() for every frame received, markPending() once a frame
+// changed what the gauge shows, and displayed() after the change reached the panel.
+
+static const uint32_t clockPingInterval = 2000;    // ms
+static const uint32_t clockPingFastInterval = 250; // ms, until the sample window is full
+static const size_t clockSampleCount = 8;          // the least delayed one sets the offset
+static const int64_t clockMaxRoundTrip = 50000;    // us, slower pongs are dropped
+
+class ClockSync {
+public:
+  // After Transport::begin()
+  void begin() {
+    ping(millis());
+  }
+
+  void service(uint32_t now) {
+    const uint32_t interval = sampleCount < clockSampleCount ? clockPingFastInterval : clockPingInterval;
+    if (now - pingedAt >= interval) {
+      ping(now);
+    }
+  }
+
+  void onPong(const ClockPongMessage& pong, int64_t receivedUs) {
+    // t0 ping sent, t1 hub received, t2 hub answered, t3 pong received
+    const int64_t delay = (receivedUs - pong.gaugeSentUs) - (pong.hubSentUs - pong.hubReceivedUs);
+    if (delay < 0 || delay > clockMaxRoundTrip) {
+      return;
+    }
+    Sample& s = samples[nextSample];
+    s.offsetUs = ((pong.hubReceivedUs - pong.gaugeSentUs) + (pong.hubSentUs - receivedUs)) / 2;
+    s.roundTripUs = delay;
+    nextSample = (nextSample + 1) % clockSampleCount;
+    if (sampleCount < clockSampleCount) {
+      sampleCount++;
+    }
+
+    // Queueing only ever adds delay, the fastest exchange is the most symmetric one
+    size_t best = 0;
+    for (size_t i = 1; i < sampleCount; i++) {
+      if (samples[i].roundTripUs < samples[best].roundTripUs) {
+        best = i;
+      }
+    }
+    offsetUs = samples[best].offsetUs;
+    roundTripUs = samples[best].roundTripUs;
+  }
+
+  bool synced() const {
+    return sampleCount > 0;
+  }
+
+  // header.ms holds whole hub milliseconds, so half a millisecond is taken off to center the
+  // truncation; transit is good to about that plus half the round trip asymmetry
+  bool transitMicros(uint32_t hubMs, int64_t receivedUs, uint32_t& transit) const {
+    if (!synced()) {
+      return false;
+    }
+    const int64_t hubUs = receivedUs + offsetUs;
+    const int64_t hubNowMs = hubUs / 1000;
+    const int64_t sentMs = hubNowMs - (int32_t)((uint32_t)hubNowMs - hubMs);
+    const int64_t t = hubUs - sentMs * 1000 - 500;
+    transit = t < 0 ? 0 : (uint32_t)t;
+    return true;
+  }
+
+  void print(Print& out) const {
+    if (!synced()) {
+      out.println("clock not synced");
+      return;
+    }
+    out.printf("clock offset %lld us, round trip %lld us (%u samples)\n",
+               (long long)offsetUs, (long long)roundTripUs, (unsigned)sampleCount);
+  }
+
+private:
+  void ping(uint32_t now) {
+    message.header.seq++;
+    message.header.ms = now;
+    message.header.schema = messageSchema;
+    message.gaugeSentUs = esp_timer_get_time();
+    Transport::send(Transport::broadcastMac, reinterpret_cast<const uint8_t*>(&message), sizeof(message));
+    pingedAt = now;
+  }
+
+  struct Sample {
+    int64_t offsetUs;
+    int64_t roundTripUs;
+  };
+
+  ClockPingMessage message{};
+  uint32_t pingedAt = 0;
+  Sample samples[clockSampleCount]{};
+  size_t sampleCount = 0;
+  size_t nextSample = 0;
+  int64_t offsetUs = 0;
+  int64_t roundTripUs = 0;
+};
+
+// 250 us buckets up to 64 ms, the last bucket also holds everything slower. Counts are halved
+// every latencyWindow samples so the percentiles follow recent behaviour.
+static const uint32_t latencyBucketWidth = 250; // us
+static const size_t latencyBucketCount = 256;
+static const uint32_t latencyWindow = 2048;
+
+class LatencyHistogram {
+public:
+  void record(uint32_t us) {
+    const size_t bucket = us / latencyBucketWidth;
+    counts[bucket < latencyBucketCount ? bucket : latencyBucketCount - 1]++;
+    if (++total >= latencyWindow) {
+      total = 0;
+      for (uint16_t& c : counts) {
+        c /= 2;
+        total += c;
+      }
+    }
+  }
+
+  // Upper edge of the bucket holding the given percentile, in us
+  uint32_t percentile(uint8_t p) const {
+    const uint32_t rank = (total * p + 99) / 100;
+    uint32_t seen = 0;
+    for (size_t i = 0; i < latencyBucketCount; i++) {
+      seen += counts[i];
+      if (seen >= rank && seen > 0) {
+        return (i + 1) * latencyBucketWidth;
+      }
+    }
+    return 0;
+  }
+
+  void print(Print& out, const char* name) const {
+    out.printf("%-12s %8u %7.2f %7.2f %7.2f\n", name, (unsigned)total,
+               percentile(50) / 1000.0, percentile(95) / 1000.0, percentile(99) / 1000.0);
+  }
+
+private:
+  uint16_t counts[latencyBucketCount]{};
+  uint32_t total = 0;
+};
+
+class LatencyStats {
+public:
+  void begin() {
+    clock.begin();
+  }
+
+  void service(uint32_t now) {
+    clock.service(now);
+  }
+
+  // From the receive callback, before the frame is dispatched
+  void recordFrame(const uint8_t* data, int len) {
+    const int64_t receivedUs = esp_timer_get_time();
+    if (len < (int)sizeof(MessageHeader)) {
+      return;
+    }
+    const MessageHeader* header = reinterpret_cast<const MessageHeader*>(data);
+    if (header->schema != messageSchema) {
+      return;
+    }
+    if (header->category == MessageCategory::ClockPong) {
+      if (len == (int)sizeof(ClockPongMessage)) {
+        clock.onPong(*reinterpret_cast<const ClockPongMessage*>(data), receivedUs);
+      }
+      return;
+    }
+    if (header->category == MessageCategory::Subscribe || header->category == MessageCategory::ClockPing) {
+      return; // another gauge talking to the hub
+    }
+    frameReceivedUs = (uint32_t)receivedUs;
+    uint32_t us;
+    if (clock.transitMicros(header->ms, receivedUs, us)) {
+      transit.record(us);
+    }
+  }
+
+  // The frame just received changed the picture; the oldest change not yet shown is the one timed
+  void markPending() {
+    if (!pendingSince) {
+      pendingSince = frameReceivedUs | 1;
+    }
+  }
+
+  void displayed() {
+    const uint32_t since = pendingSince;
+    if (since) {
+      pendingSince = 0;
+      display.record((uint32_t)esp_timer_get_time() - since);
+    }
+  }
+
+  void print(Print& out) const {
+    out.println("latency (ms)  samples     p50     p95     p99");
+    transit.print(out, "transit");
+    display.print(out, "display");
+    clock.print(out);
+  }
+
+private:
+  ClockSync clock;
+  LatencyHistogram transit;
+  LatencyHistogram display;
+  uint32_t frameReceivedUs = 0;
+  volatile uint32_t pendingSince = 0; // 0 when nothing waits for the panel
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <Arduino.h>
+#include "message.h"
+#include "latency_stats.h"
+#include "telemetry.h"
+#include "fec.h"
+
+// Receive accounting per message category, based on MessageHeader::seq gaps.
+// Call recordFrame() for every frame received, and serviceConsole() from loop();
+// sending 's' over serial prints the counters, the hub's last telemetry, and the latency
+// histograms and parity recoveries when given.
+class LinkStats {
+public:
+  // A unicast frame is counted as a whole, its seq is per gauge and its records have none
+  void recordFrame(const uint8_t* data, int len) {
+    if (len < (int)sizeof(MessageHeader)) {
+      return;
+    }
+    const MessageHeader* header = reinterpret_cast<const MessageHeader*>(data);
+    if (header->schema != messageSchema) {
+      schemaMismatches++; // forEachMessage() drops it, here it is counted once per frame
+      return;
+    }
+    if (header->category == MessageCategory::Unicast) {
+      record(*header);
+      return;
+    }
+    forEachMessage(data, len, [this](const uint8_t* message, int messageLen) {
+      const MessageHeader* h = reinterpret_cast<const MessageHeader*>(message);
+      if (h->category == MessageCategory::Subscribe || h->category == MessageCategory::ClockPing) {
+        return; // another gauge talking to the hub, its seq is that gauge's own
+      }
+      record(*h);
+      if (h->category == MessageCategory::Telemetry && messageLen == (int)sizeof(TelemetryMessage)) {
+        memcpy(&hubTelemetry, message, sizeof(hubTelemetry));
+        hasHubTelemetry = true;
+      }
+    });
+  }
+
+  void record(const MessageHeader& header) {
+    const size_t index = static_cast<size_t>(header.category);
+    if (index >= messageCategoryCount) {
+      return;
+    }
+
+    Counters& c = counters[index];
+    c.received++;
+    if (!c.seen) {
+      c.seen = true;
+      c.lastSeq = header.seq;
+      return;
+    }
+
+    const uint8_t gap = header.seq - c.lastSeq;
+    if (gap == 0 || gap >= 128) {
+      // Duplicate or late frame; a late one was already counted as lost
+      c.reordered++;
+      if (gap != 0 && c.lost > 0) {
+        c.lost--;
+      }
+      return;
+    }
+    c.lost += gap - 1;
+    c.lastSeq = header.seq;
+  }
+
+  void print(Print& out) const {
+    out.println("category        received     lost reordered");
+    for (size_t i = 0; i < messageCategoryCount; i++) {
+      const Counters& c = counters[i];
+      if (!c.seen) {
+        continue;
+      }
+      out.printf("%-14s %9u %8u %9u\n", categoryName(static_cast<MessageCategory>(i)),
+                 (unsigned)c.received, (unsigned)c.lost, (unsigned)c.reordered);
+    }
+    if (schemaMismatches) {
+      out.printf("%u frames from a different message schema dropped\n", (unsigned)schemaMismatches);
+    }
+    if (hasHubTelemetry) {
+      printTelemetry(out, hubTelemetry);
+    }
+  }
+
+  void serviceConsole(Stream& console, const LatencyStats* latency = nullptr, const FecReceiver* fec = nullptr) const {
+    while (console.available() > 0) {
+      if (console.read() == 's') {
+        print(console);
+        if (fec) {
+          fec->print(console);
+        }
+        if (latency) {
+          latency->print(console);
+        }
+      }
+    }
+  }
+
+private:
+  struct Counters {
+    uint32_t received;
+    uint32_t lost;
+    uint32_t reordered;
+    uint8_t lastSeq;
+    bool seen;
+  };
+
+  Counters counters[messageCategoryCount]{};
+  uint32_t schemaMismatches = 0; // frames from a different messageSchema
+  TelemetryMessage hubTelemetry{};
+  bool hasHubTelemetry = false;
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
 
 #ifndef ESP_CHANNEL
@@ -10,6 +12,8 @@
   #define ESP_MAX_TX_POWER 20
 #endif
 
+#define MAX_FRAME_SIZE 250 // ESP_NOW_MAX_DATA_LEN
+
 #define MAX_VALUE 65535
 #define MID_VALUE (MAX_VALUE / 2)
 
@@ -21,34 +25,49 @@ enum class MessageCategory : uint8_t {
   RadarAltimeter,
   Integer,
   SAI,
+  IFEIDelta,
+  Superframe,
+  IFEICompact,
+  Subscribe,
+  Unicast,
+  ClockPing,
+  ClockPong,
+  Trend,
+  Telemetry,
+  Parity,
+  Attitude,
+  Count, // Keep last
 };
 
+static constexpr size_t messageCategoryCount = static_cast<size_t>(MessageCategory::Count);
+static_assert(messageCategoryCount <= 32, "SubscribeMessage::categories has one bit per category");
+
 enum class ValueName : uint8_t;
 
 struct __attribute__((packed)) MessageHeader {
   MessageCategory category;
+  uint8_t seq;       // per-category counter, wraps at 256
   uint32_t ms;       // millis() at send time
+  uint8_t schema;    // messageSchema of the sender, see message_schema.h
 };
 
 struct __attribute__((packed)) IntegerMessage {
-  MessageHeader header{category: MessageCategory::Integer};
+  MessageHeader header{category: MessageCategory::Integer, seq: 0, ms: 0, schema: 0};
   ValueName name;
   uint16_t value;
 };
 
+// What the standby altimeter reads rather than where its drums stand, the hub decodes the drums
+// and the gauge draws them back from this (altimeter_codec.h)
 struct __attribute__((packed)) AltimeterMessage {
-  MessageHeader header{category: MessageCategory::Altimeter};
+  MessageHeader header{category: MessageCategory::Altimeter, seq: 0, ms: 0, schema: 0};
 
-  uint16_t alt100FtPtr;
-  uint16_t alt1000FtCnt;
-  uint16_t alt10000FtCnt;
-  uint16_t pressSet0;
-  uint16_t pressSet1;
-  uint16_t pressSet2;
+  int32_t altitude;  // feet * altitudeScale
+  uint16_t kollsman; // hundredths of an inch of mercury
 };
 
 struct __attribute__((packed)) RadarAltimeterMessage {
-  MessageHeader header{category: MessageCategory::RadarAltimeter};
+  MessageHeader header{category: MessageCategory::RadarAltimeter, seq: 0, ms: 0, schema: 0};
 
   uint16_t altPtr;
   uint16_t minHeightPtr;
@@ -58,7 +77,7 @@ struct __attribute__((packed)) RadarAltimeterMessage {
 };
 
 struct __attribute__((packed)) IfeiMessage {
-  MessageHeader header{category: MessageCategory::IFEI};
+  MessageHeader header{category: MessageCategory::IFEI, seq: 0, ms: 0, schema: 0};
 
   int8_t clockH = -1; // use -1 to represent space(empty)
   int8_t clockM = -1;
@@ -123,8 +142,68 @@ struct __attribute__((packed)) IfeiMessage {
   uint16_t colorMode;
 };
 
+// Only the IfeiMessage fields flagged in `changed` follow, in ifeiFields order. A delta applies
+// only to the state it was made against, a gauge that lost one waits for the next keyframe.
+struct __attribute__((packed)) IfeiDeltaMessage {
+  MessageHeader header{category: MessageCategory::IFEIDelta, seq: 0, ms: 0, schema: 0};
+
+  uint16_t baseMs; // low bits of that state's header.ms
+  uint64_t changed;
+  uint8_t payload[sizeof(IfeiMessage) - sizeof(MessageHeader)];
+};
+
+// Batches several messages into one broadcast as TLV records:
+// [category][length][message], where message carries its own MessageHeader
+struct __attribute__((packed)) SuperframeMessage {
+  MessageHeader header{category: MessageCategory::Superframe, seq: 0, ms: 0, schema: 0};
+
+  uint8_t records[MAX_FRAME_SIZE - sizeof(MessageHeader)];
+};
+
+// Records of an acknowledged unicast frame to one gauge, laid out like SuperframeMessage. Its
+// header seq counts per gauge, the records inside carry no sequence of their own.
+typedef SuperframeMessage UnicastMessage;
+
+// Sent by a gauge at boot and every subscriptionInterval, see subscription.h
+struct __attribute__((packed)) SubscribeMessage {
+  MessageHeader header{category: MessageCategory::Subscribe, seq: 0, ms: 0, schema: 0};
+
+  uint32_t categories; // bit per MessageCategory
+  uint16_t values;     // bit per ValueName
+};
+
+// NTP style clock exchange: a gauge broadcasts a ping, the hub answers with a unicast pong that
+// echoes the ping's seq. Times are esp_timer_get_time() microseconds of the side that took them.
+struct __attribute__((packed)) ClockPingMessage {
+  MessageHeader header{category: MessageCategory::ClockPing, seq: 0, ms: 0, schema: 0};
+
+  int64_t gaugeSentUs;
+};
+
+struct __attribute__((packed)) ClockPongMessage {
+  MessageHeader header{category: MessageCategory::ClockPong, seq: 0, ms: 0, schema: 0};
+
+  int64_t gaugeSentUs;
+  int64_t hubReceivedUs;
+  int64_t hubSentUs;
+};
+
+// IfeiMessage in the v2 layout, see ifei_codec.h for the encoding of each part
+struct __attribute__((packed)) IfeiCompactMessage {
+  MessageHeader header{category: MessageCategory::IFEICompact, seq: 0, ms: 0, schema: 0};
+
+  uint16_t textures;    // one bit per *Tex field
+  uint8_t colons;       // dd1..dd4, two bits each
+  uint8_t colorMode;
+  uint16_t dispIntLt;
+  uint16_t extNozzlePosL;
+  uint16_t extNozzlePosR;
+  uint8_t digits[21];   // BCD, 0xF is a blank digit
+  uint8_t text[15];     // fuelUp, fuelDown, timeSetMode, t, sp, codes as 4 bit characters
+};
+
 struct __attribute__((packed)) SaiMessage {
-  MessageHeader header{category: MessageCategory::SAI};
+  MessageHeader header{category: MessageCategory::SAI, seq: 0, ms: 0, schema: 0};
 
   uint16_t slipBall = MID_VALUE;
   uint16_t bank = MID_VALUE;
@@ -135,6 +214,19 @@ struct __attribute__((packed)) SaiMessage {
   uint16_t pointerHor = MID_VALUE;
   uint16_t pointerVer = MID_VALUE;
 };
+
+// Pitch, bank and slip ball of the SAI between two full SaiMessages, each as
+// base + (delta << shift) where base is the last SaiMessage, identified by the low bits of its
+// header.ms. See attitude_codec.h.
+struct __attribute__((packed)) AttitudeMessage {
+  MessageHeader header{category: MessageCategory::Attitude, seq: 0, ms: 0, schema: 0};
+
+  uint16_t baseMs;
+  uint8_t shift;
+  int8_t pitch;
+  int8_t bank;
+  int8_t slipBall;
+};
 #pragma pack(pop)
 
 enum class MissionType : uint8_t {
@@ -154,32 +246,174 @@ enum class ValueName : uint8_t {
   InstrumentLighting,
   ConsoleLighting,
   MissionChanged,
+  Count, // Keep last
+};
+
+static constexpr size_t valueNameCount = static_cast<size_t>(ValueName::Count);
+static_assert(valueNameCount <= 16, "SubscribeMessage::values has one bit per value");
+
+// Continuous values the hub sends a rate of change for, see dead_reckoning.h
+enum class TrendField : uint8_t {
+  Airspeed,
+  VerticalVelocityIndicator,
+  Altitude, // AltimeterMessage::altitude per second
+  SaiBank,
+  SaiPitch,
+  SaiSlipBall,
+  SaiRateOfTurn,
+  Count, // Keep last
+};
+
+static constexpr size_t trendFieldCount = static_cast<size_t>(TrendField::Count);
+static_assert(trendFieldCount <= 8, "TrendMessage::fields has one bit per field");
+
+// Rates in raw units per second for the fields flagged in `fields`, in TrendField order. Queued
+// after the values in the same frame; a 0 rate is sent once a value stops moving.
+struct __attribute__((packed)) TrendMessage {
+  MessageHeader header{category: MessageCategory::Trend, seq: 0, ms: 0, schema: 0};
+
+  uint8_t fields;
+  int16_t rates[trendFieldCount];
+};
+
+// The hub's own view of the last telemetryInterval, broadcast once per interval (telemetry.h)
+struct __attribute__((packed)) TelemetryMessage {
+  MessageHeader header{category: MessageCategory::Telemetry, seq: 0, ms: 0, schema: 0};
+
+  uint16_t framesSent;
+  uint16_t airtimeBytes;  // frame overhead included
+  uint16_t sendFailures;  // refused by the driver or not acknowledged
+  uint16_t superseded;    // replaced by a newer value before they went out
+  uint16_t exportFrames;  // complete DCS-BIOS export frames
+  uint32_t dcsBiosBytes;  // can pass 64 KB/s on native USB
+  uint16_t dcsBiosSkipped; // permille of written export words no field of interest reads
+  uint16_t rxErrors;      // FIFO overflows and full receive buffer
+  uint16_t loopMeanUs;
+  uint16_t loopMaxUs;     // longest loop() iteration
+  uint8_t backoff[3];     // minInterval stretch of High, Normal, Low priority at the end, in eighths
+  uint16_t records[messageCategoryCount]; // sent per category, superframe records included
 };
 
-static bool isEqualAltimeterMessage(const AltimeterMessage& a, const AltimeterMessage& b) {
-  constexpr size_t off = offsetof(AltimeterMessage, alt100FtPtr);
-  return std::memcmp(reinterpret_cast<const uint8_t*>(&a) + off,
-                     reinterpret_cast<const uint8_t*>(&b) + off,
-                     sizeof(AltimeterMessage) - off) == 0;
+// XOR of `count` records of category `protects` with consecutive seqs from firstSeq, headers
+// included; `parity` is as long as those records. See fec.h.
+struct __attribute__((packed)) ParityMessage {
+  MessageHeader header{category: MessageCategory::Parity, seq: 0, ms: 0, schema: 0};
+
+  MessageCategory protects;
+  uint8_t firstSeq;
+  uint8_t count;
+  uint8_t parity[sizeof(SaiMessage)];
+};
+
+static constexpr uint32_t categoryBit(MessageCategory category) {
+  return 1u << static_cast<uint8_t>(category);
+}
+
+static constexpr uint16_t valueBit(ValueName name) {
+  return (uint16_t)(1u << static_cast<uint8_t>(name));
+}
+
+static inline const char* categoryName(MessageCategory category) {
+  switch (category) {
+  case MessageCategory::Common: return "Common";
+  case MessageCategory::IFEI: return "IFEI";
+  case MessageCategory::Altimeter: return "Altimeter";
+  case MessageCategory::RadarAltimeter: return "RadarAltimeter";
+  case MessageCategory::Integer: return "Integer";
+  case MessageCategory::SAI: return "SAI";
+  case MessageCategory::IFEIDelta: return "IFEIDelta";
+  case MessageCategory::Superframe: return "Superframe";
+  case MessageCategory::IFEICompact: return "IFEICompact";
+  case MessageCategory::Subscribe: return "Subscribe";
+  case MessageCategory::Unicast: return "Unicast";
+  case MessageCategory::ClockPing: return "ClockPing";
+  case MessageCategory::ClockPong: return "ClockPong";
+  case MessageCategory::Trend: return "Trend";
+  case MessageCategory::Telemetry: return "Telemetry";
+  case MessageCategory::Parity: return "Parity";
+  case MessageCategory::Attitude: return "Attitude";
+  default: return "?";
+  }
+}
+
+#include "message_schema.h"
+
+// Fill `delta` with the fields that differ between `from` and `to`, returns the number of bytes to send
+static inline size_t makeIfeiDelta(const IfeiMessage& from, const IfeiMessage& to, IfeiDeltaMessage& delta) {
+  delta.baseMs = (uint16_t)from.header.ms;
+  delta.changed = changedFields(from, to);
+  return offsetof(IfeiDeltaMessage, payload) + packFields(to, delta.changed, delta.payload);
+}
+
+// Apply a received IfeiDeltaMessage of `len` bytes onto the last known state
+static inline bool applyIfeiDelta(IfeiMessage& m, const uint8_t* data, int len) {
+  constexpr int payloadOffset = offsetof(IfeiDeltaMessage, payload);
+  if (len < payloadOffset) {
+    return false;
+  }
+
+  uint16_t baseMs;
+  std::memcpy(&baseMs, data + offsetof(IfeiDeltaMessage, baseMs), sizeof(baseMs));
+  if (baseMs != (uint16_t)m.header.ms) {
+    return false; // made against a state this gauge does not have
+  }
+  uint64_t changed;
+  std::memcpy(&changed, data + offsetof(IfeiDeltaMessage, changed), sizeof(changed));
+  // Validated as a whole first so a truncated delta never leaves a half-applied state
+  if (!unpackFields(m, changed, data + payloadOffset, len - payloadOffset)) {
+    return false;
+  }
+  std::memcpy(&m.header, data, sizeof(MessageHeader));
+  m.header.category = MessageCategory::IFEI;
+  return true;
 }
 
-static bool isEqualRadarAltimeterMessage(const RadarAltimeterMessage& a, const RadarAltimeterMessage& b) {
-  constexpr size_t off = offsetof(RadarAltimeterMessage, altPtr);
-  return std::memcmp(reinterpret_cast<const uint8_t*>(&a) + off,
-                     reinterpret_cast<const uint8_t*>(&b) + off,
-                     sizeof(RadarAltimeterMessage) - off) == 0;
+// Append a message to a superframe under construction, `used` starts at sizeof(MessageHeader)
+static inline bool appendSuperframeRecord(SuperframeMessage& frame, size_t& used, const void* message, size_t len) {
+  if (len < sizeof(MessageHeader) || used + 2 + len > MAX_FRAME_SIZE) {
+    return false;
+  }
+  uint8_t* p = reinterpret_cast<uint8_t*>(&frame) + used;
+  p[0] = static_cast<uint8_t>(reinterpret_cast<const MessageHeader*>(message)->category);
+  p[1] = static_cast<uint8_t>(len);
+  std::memcpy(p + 2, message, len);
+  used += 2 + len;
+  return true;
 }
 
-static bool isEqualIfeiMessage(const IfeiMessage& a, const IfeiMessage& b) {
-  constexpr size_t off = offsetof(IfeiMessage, clockH);
-  return std::memcmp(reinterpret_cast<const uint8_t*>(&a) + off,
-                     reinterpret_cast<const uint8_t*>(&b) + off,
-                     sizeof(IfeiMessage) - off) == 0;
+static inline bool isRecordContainer(MessageCategory category) {
+  return category == MessageCategory::Superframe || category == MessageCategory::Unicast;
 }
 
-static bool isEqualSaiMessage(const SaiMessage& a, const SaiMessage& b) {
-  constexpr size_t off = offsetof(SaiMessage, slipBall);
-  return std::memcmp(reinterpret_cast<const uint8_t*>(&a) + off,
-                     reinterpret_cast<const uint8_t*>(&b) + off,
-                     sizeof(SaiMessage) - off) == 0;
+// Call handler(data, len) for a plain message, or for every record of a superframe or unicast frame
+template<typename Handler>
+static inline void forEachMessage(const uint8_t* data, int len, Handler handler) {
+  if (len < (int)sizeof(MessageHeader)) {
+    return;
+  }
+
+  const MessageHeader* hdr = reinterpret_cast<const MessageHeader*>(data);
+  if (hdr->schema != messageSchema) {
+    return; // a different message layout, see message_schema.h
+  }
+  if (!isRecordContainer(hdr->category)) {
+    handler(data, len);
+    return;
+  }
+
+  const uint8_t* p = data + sizeof(MessageHeader);
+  const uint8_t* end = data + len;
+  while (end - p >= 2) {
+    const uint8_t type = p[0];
+    const int recordLen = p[1];
+    p += 2;
+    if (recordLen < (int)sizeof(MessageHeader) || recordLen > end - p || type != p[0]) {
+      return; // malformed, drop the rest
+    }
+    if (reinterpret_cast<const MessageHeader*>(p)->schema != messageSchema) {
+      return;
+    }
+    handler(p, recordLen);
+    p += recordLen;
+  }
 }
@@ -0,0 +1,262 @@
+#pragma once
+
+// Part of message.h: a field table per fixed size message, and what is derived from it. The
+// tables drive equality, changed field masks (IFEI deltas), serialization and the schema hash
+// every MessageHeader carries, so hub and gauges built from different message layouts drop
+// each other's frames instead of misreading them.
+
+struct MessageField {
+  uint8_t offset;
+  uint8_t size;
+};
+
+#define MESSAGE_FIELD(type, name) MessageField{ offsetof(type, name), sizeof(type::name) }
+
+#define IFEI_FIELD(name) MESSAGE_FIELD(IfeiMessage, name)
+
+static constexpr MessageField ifeiFields[] = {
+  IFEI_FIELD(clockH), IFEI_FIELD(clockM), IFEI_FIELD(clockS),
+  IFEI_FIELD(timerH), IFEI_FIELD(timerM), IFEI_FIELD(timerS),
+  IFEI_FIELD(bingo),
+  IFEI_FIELD(dd1), IFEI_FIELD(dd2), IFEI_FIELD(dd3), IFEI_FIELD(dd4),
+  IFEI_FIELD(ffL), IFEI_FIELD(ffR),
+  IFEI_FIELD(rpmL), IFEI_FIELD(rpmR),
+  IFEI_FIELD(tempL), IFEI_FIELD(tempR),
+  IFEI_FIELD(oilPressL), IFEI_FIELD(oilPressR),
+  IFEI_FIELD(extNozzlePosL), IFEI_FIELD(extNozzlePosR),
+  IFEI_FIELD(fuelUp), IFEI_FIELD(fuelDown), IFEI_FIELD(timeSetMode), IFEI_FIELD(t),
+  IFEI_FIELD(sp), IFEI_FIELD(codes),
+  IFEI_FIELD(bingoTex), IFEI_FIELD(ffTex),
+  IFEI_FIELD(lTex), IFEI_FIELD(l0Tex), IFEI_FIELD(l50Tex), IFEI_FIELD(l100Tex), IFEI_FIELD(lPointerTex), IFEI_FIELD(lScaleTex),
+  IFEI_FIELD(rTex), IFEI_FIELD(r0Tex), IFEI_FIELD(r50Tex), IFEI_FIELD(r100Tex), IFEI_FIELD(rPointerTex), IFEI_FIELD(rScaleTex),
+  IFEI_FIELD(nozTex), IFEI_FIELD(oilTex), IFEI_FIELD(rpmTex), IFEI_FIELD(tempTex), IFEI_FIELD(zTex),
+  IFEI_FIELD(dispIntLt), IFEI_FIELD(colorMode),
+};
+#undef IFEI_FIELD
+
+static constexpr size_t ifeiFieldCount = sizeof(ifeiFields) / sizeof(ifeiFields[0]);
+static_assert(ifeiFieldCount <= 64, "IfeiDeltaMessage::changed has one bit per field");
+
+static constexpr MessageField altimeterFields[] = {
+  MESSAGE_FIELD(AltimeterMessage, altitude), MESSAGE_FIELD(AltimeterMessage, kollsman),
+};
+
+static constexpr MessageField radarAltimeterFields[] = {
+  MESSAGE_FIELD(RadarAltimeterMessage, altPtr), MESSAGE_FIELD(RadarAltimeterMessage, minHeightPtr),
+  MESSAGE_FIELD(RadarAltimeterMessage, offFlag), MESSAGE_FIELD(RadarAltimeterMessage, greenLamp),
+  MESSAGE_FIELD(RadarAltimeterMessage, warnLt),
+};
+
+static constexpr MessageField saiFields[] = {
+  MESSAGE_FIELD(SaiMessage, slipBall), MESSAGE_FIELD(SaiMessage, bank),
+  MESSAGE_FIELD(SaiMessage, rateOfTurn), MESSAGE_FIELD(SaiMessage, manPitchAdj),
+  MESSAGE_FIELD(SaiMessage, pitch), MESSAGE_FIELD(SaiMessage, attWarningFlag),
+  MESSAGE_FIELD(SaiMessage, pointerHor), MESSAGE_FIELD(SaiMessage, pointerVer),
+};
+
+static constexpr MessageField integerFields[] = {
+  MESSAGE_FIELD(IntegerMessage, name), MESSAGE_FIELD(IntegerMessage, value),
+};
+
+static constexpr MessageField ifeiCompactFields[] = {
+  MESSAGE_FIELD(IfeiCompactMessage, textures), MESSAGE_FIELD(IfeiCompactMessage, colons),
+  MESSAGE_FIELD(IfeiCompactMessage, colorMode), MESSAGE_FIELD(IfeiCompactMessage, dispIntLt),
+  MESSAGE_FIELD(IfeiCompactMessage, extNozzlePosL), MESSAGE_FIELD(IfeiCompactMessage, extNozzlePosR),
+  MESSAGE_FIELD(IfeiCompactMessage, digits), MESSAGE_FIELD(IfeiCompactMessage, text),
+};
+
+static constexpr MessageField subscribeFields[] = {
+  MESSAGE_FIELD(SubscribeMessage, categories), MESSAGE_FIELD(SubscribeMessage, values),
+};
+
+static constexpr MessageField clockPingFields[] = {
+  MESSAGE_FIELD(ClockPingMessage, gaugeSentUs),
+};
+
+static constexpr MessageField clockPongFields[] = {
+  MESSAGE_FIELD(ClockPongMessage, gaugeSentUs), MESSAGE_FIELD(ClockPongMessage, hubReceivedUs),
+  MESSAGE_FIELD(ClockPongMessage, hubSentUs),
+};
+
+static constexpr MessageField attitudeFields[] = {
+  MESSAGE_FIELD(AttitudeMessage, baseMs), MESSAGE_FIELD(AttitudeMessage, shift),
+  MESSAGE_FIELD(AttitudeMessage, pitch), MESSAGE_FIELD(AttitudeMessage, bank),
+  MESSAGE_FIELD(AttitudeMessage, slipBall),
+};
+
+static constexpr MessageField telemetryFields[] = {
+  MESSAGE_FIELD(TelemetryMessage, framesSent), MESSAGE_FIELD(TelemetryMessage, airtimeBytes),
+  MESSAGE_FIELD(TelemetryMessage, sendFailures), MESSAGE_FIELD(TelemetryMessage, superseded),
+  MESSAGE_FIELD(TelemetryMessage, exportFrames), MESSAGE_FIELD(TelemetryMessage, dcsBiosBytes),
+  MESSAGE_FIELD(TelemetryMessage, dcsBiosSkipped), MESSAGE_FIELD(TelemetryMessage, rxErrors),
+  MESSAGE_FIELD(TelemetryMessage, loopMeanUs), MESSAGE_FIELD(TelemetryMessage, loopMaxUs),
+  MESSAGE_FIELD(TelemetryMessage, backoff), MESSAGE_FIELD(TelemetryMessage, records),
+};
+#undef MESSAGE_FIELD
+
+static constexpr size_t fieldBytes(const MessageField* fields, size_t count) {
+  return count == 0 ? 0 : fields->size + fieldBytes(fields + 1, count - 1);
+}
+
+template<typename T>
+struct MessageSchema;
+
+// The table has to cover every byte after the header
+#define MESSAGE_SCHEMA(type, messageCategory, table)                                                     \
+  template<>                                                                                             \
+  struct MessageSchema<type> {                                                                           \
+    static constexpr MessageCategory category() { return messageCategory; }                             \
+    static constexpr const MessageField* fields() { return table; }                                     \
+    static constexpr size_t fieldCount() { return sizeof(table) / sizeof(table[0]); }                   \
+  };                                                                                                     \
+  static_assert(sizeof(table) / sizeof(table[0]) <= 64, #type " has one changed bit per field");       \
+  static_assert(sizeof(MessageHeader) + fieldBytes(table, sizeof(table) / sizeof(table[0])) == sizeof(type), \
+                #type " fields do not cover the message");
+
+MESSAGE_SCHEMA(IfeiMessage, MessageCategory::IFEI, ifeiFields)
+MESSAGE_SCHEMA(AltimeterMessage, MessageCategory::Altimeter, altimeterFields)
+MESSAGE_SCHEMA(RadarAltimeterMessage, MessageCategory::RadarAltimeter, radarAltimeterFields)
+MESSAGE_SCHEMA(SaiMessage, MessageCategory::SAI, saiFields)
+MESSAGE_SCHEMA(IntegerMessage, MessageCategory::Integer, integerFields)
+MESSAGE_SCHEMA(IfeiCompactMessage, MessageCategory::IFEICompact, ifeiCompactFields)
+MESSAGE_SCHEMA(SubscribeMessage, MessageCategory::Subscribe, subscribeFields)
+MESSAGE_SCHEMA(ClockPingMessage, MessageCategory::ClockPing, clockPingFields)
+MESSAGE_SCHEMA(ClockPongMessage, MessageCategory::ClockPong, clockPongFields)
+MESSAGE_SCHEMA(TelemetryMessage, MessageCategory::Telemetry, telemetryFields)
+MESSAGE_SCHEMA(AttitudeMessage, MessageCategory::Attitude, attitudeFields)
+#undef MESSAGE_SCHEMA
+
+// FNV-1a over every table, the header and the enums whose size shapes a message. Recursive
+// rather than looped so the C++11 cores (sari, ifei) evaluate it at compile time too.
+static constexpr uint32_t schemaMix(uint32_t h, uint32_t v) {
+  return (h ^ v) * 16777619u;
+}
+
+static constexpr uint32_t schemaMixFields(uint32_t h, const MessageField* fields, size_t count) {
+  return count == 0 ? h : schemaMixFields(schemaMix(schemaMix(h, fields->offset), fields->size), fields + 1, count - 1);
+}
+
+template<typename T>
+static constexpr uint32_t schemaMixMessage(uint32_t h) {
+  return schemaMixFields(schemaMix(schemaMix(h, static_cast<uint8_t>(MessageSchema<T>::category())), sizeof(T)),
+                         MessageSchema<T>::fields(), MessageSchema<T>::fieldCount());
+}
+
+static constexpr uint32_t messageSchemaHash =
+  schemaMixMessage<IfeiMessage>(
+  schemaMixMessage<AltimeterMessage>(
+  schemaMixMessage<RadarAltimeterMessage>(
+  schemaMixMessage<SaiMessage>(
+  schemaMixMessage<IntegerMessage>(
+  schemaMixMessage<IfeiCompactMessage>(
+  schemaMixMessage<SubscribeMessage>(
+  schemaMixMessage<ClockPingMessage>(
+  schemaMixMessage<ClockPongMessage>(
+  schemaMixMessage<TelemetryMessage>(
+  schemaMixMessage<AttitudeMessage>(
+    schemaMix(schemaMix(schemaMix(schemaMix(schemaMix(schemaMix(schemaMix(2166136261u,
+      sizeof(MessageHeader)), messageCategoryCount), valueNameCount), trendFieldCount),
+      sizeof(IfeiDeltaMessage)), sizeof(TrendMessage)), sizeof(ParityMessage)))))))))))));
+
+static constexpr uint8_t schemaFold(uint32_t h) {
+  return (uint8_t)(h ^ (h >> 8) ^ (h >> 16) ^ (h >> 24));
+}
+
+// What MessageHeader::schema holds, never 0 so a header nobody stamped is rejected too
+static constexpr uint8_t messageSchema = schemaFold(messageSchemaHash) ? schemaFold(messageSchemaHash) : 1;
+
+template<typename T>
+static constexpr uint64_t allFields() {
+  return MessageSchema<T>::fieldCount() == 64 ? ~0ULL : (1ULL << MessageSchema<T>::fieldCount()) - 1;
+}
+
+// Bit i set when field i differs, the header is not compared
+template<typename T>
+static inline uint64_t changedFields(const T& a, const T& b) {
+  const uint8_t* pa = reinterpret_cast<const uint8_t*>(&a);
+  const uint8_t* pb = reinterpret_cast<const uint8_t*>(&b);
+  uint64_t changed = 0;
+  for (size_t i = 0; i < MessageSchema<T>::fieldCount(); i++) {
+    const MessageField& f = MessageSchema<T>::fields()[i];
+    if (std::memcmp(pa + f.offset, pb + f.offset, f.size) != 0) {
+      changed |= 1ULL << i;
+    }
+  }
+  return changed;
+}
+
+template<typename T>
+static inline bool isEqualMessage(const T& a, const T& b) {
+  const uint8_t* pa = reinterpret_cast<const uint8_t*>(&a);
+  const uint8_t* pb = reinterpret_cast<const uint8_t*>(&b);
+  for (size_t i = 0; i < MessageSchema<T>::fieldCount(); i++) {
+    const MessageField& f = MessageSchema<T>::fields()[i];
+    if (std::memcmp(pa + f.offset, pb + f.offset, f.size) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Writes the fields flagged in `mask` back to back, in table order, returns the bytes written
+template<typename T>
+static inline size_t packFields(const T& m, uint64_t mask, uint8_t* out) {
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(&m);
+  size_t used = 0;
+  for (size_t i = 0; i < MessageSchema<T>::fieldCount(); i++) {
+    if (mask & (1ULL << i)) {
+      const MessageField& f = MessageSchema<T>::fields()[i];
+      std::memcpy(out + used, p + f.offset, f.size);
+      used += f.size;
+    }
+  }
+  return used;
+}
+
+// Reverse of packFields(). Checks `len` first, a short or long payload leaves `m` untouched.
+template<typename T>
+static inline bool unpackFields(T& m, uint64_t mask, const uint8_t* data, size_t len) {
+  size_t expected = 0;
+  for (size_t i = 0; i < 64; i++) {
+    if (mask & (1ULL << i)) {
+      if (i >= MessageSchema<T>::fieldCount()) {
+        return false;
+      }
+      expected += MessageSchema<T>::fields()[i].size;
+    }
+  }
+  if (expected != len) {
+    return false;
+  }
+
+  uint8_t* p = reinterpret_cast<uint8_t*>(&m);
+  for (size_t i = 0; i < MessageSchema<T>::fieldCount(); i++) {
+    if (mask & (1ULL << i)) {
+      const MessageField& f = MessageSchema<T>::fields()[i];
+      std::memcpy(p + f.offset, data, f.size);
+      data += f.size;
+    }
+  }
+  return true;
+}
+
+// Header and every field, returns the length
+template<typename T>
+static inline size_t serializeMessage(const T& m, uint8_t* out) {
+  std::memcpy(out, &m.header, sizeof(MessageHeader));
+  return sizeof(MessageHeader) + packFields(m, allFields<T>(), out + sizeof(MessageHeader));
+}
+
+template<typename T>
+static inline bool deserializeMessage(const uint8_t* data, int len, T& m) {
+  const MessageHeader* header = reinterpret_cast<const MessageHeader*>(data);
+  if (len < (int)sizeof(MessageHeader) || header->category != MessageSchema<T>::category() ||
+      header->schema != messageSchema) {
+    return false;
+  }
+  if (!unpackFields(m, allFields<T>(), data + sizeof(MessageHeader), len - sizeof(MessageHeader))) {
+    return false;
+  }
+  std::memcpy(&m.header, data, sizeof(MessageHeader));
+  return true;
+}
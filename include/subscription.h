@@ -0,0 +1,41 @@
+#pragma once
+
+#include <Arduino.h>
+#include "transport.h"
+#include "message.h"
+
+// A gauge tells the hub which categories and values it consumes, at boot and then every
+// subscriptionInterval. The hub answers with the current subscribed values as acknowledged
+// unicast, and sends later changes of rarely changing values the same way.
+static const uint32_t subscriptionInterval = 5000; // ms, also how the hub notices a gauge is gone
+
+class SubscriptionAnnouncer {
+public:
+  SubscriptionAnnouncer(uint32_t categories, uint16_t values) {
+    message.categories = categories;
+    message.values = values;
+  }
+
+  // After Transport::begin()
+  void begin() {
+    announce(millis());
+  }
+
+  void service(uint32_t now) {
+    if (now - announcedAt >= subscriptionInterval) {
+      announce(now);
+    }
+  }
+
+private:
+  void announce(uint32_t now) {
+    message.header.seq++;
+    message.header.ms = now;
+    message.header.schema = messageSchema;
+    Transport::send(Transport::broadcastMac, reinterpret_cast<const uint8_t*>(&message), sizeof(message));
+    announcedAt = now;
+  }
+
+  SubscribeMessage message{};
+  uint32_t announcedAt = 0;
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <Arduino.h>
+#include "message.h"
+
+// Prints a TelemetryMessage, on the hub's console and on gauges that received one. Read it next
+// to the gauge's own LinkStats: few export frames point at DCS-BIOS or the PC, a long worst loop
+// at the hub, failures or superseded values at the radio.
+static inline void printTelemetry(Print& out, const TelemetryMessage& m) {
+  out.printf("hub          %u frames/s, %u bytes/s on air, %u send failures, %u superseded\n",
+             (unsigned)m.framesSent, (unsigned)m.airtimeBytes, (unsigned)m.sendFailures, (unsigned)m.superseded);
+  out.printf("dcs-bios     %u export frames/s, %u bytes/s (%u.%u%% of words skipped), %u receive errors\n",
+             (unsigned)m.exportFrames, (unsigned)m.dcsBiosBytes, (unsigned)m.dcsBiosSkipped / 10,
+             (unsigned)m.dcsBiosSkipped % 10, (unsigned)m.rxErrors);
+  out.printf("loop         mean %u us, worst %u us\n", (unsigned)m.loopMeanUs, (unsigned)m.loopMaxUs);
+  out.printf("backoff      high x%u.%03u, normal x%u.%03u, low x%u.%03u\n", m.backoff[0] / 8u, m.backoff[0] % 8u * 125,
+             m.backoff[1] / 8u, m.backoff[1] % 8u * 125, m.backoff[2] / 8u, m.backoff[2] % 8u * 125);
+  out.println("category     records/s");
+  for (size_t i = 0; i < messageCategoryCount; i++) {
+    if (m.records[i]) {
+      out.printf("%-14s %7u\n", categoryName(static_cast<MessageCategory>(i)), (unsigned)m.records[i]);
+    }
+  }
+}
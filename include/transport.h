@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// How the hub and the gauges exchange frames. Exactly one backend is compiled in:
+//
+//   transport_espnow.h  ESP-NOW on the boards (default)
+//   transport_udp.h     UDP multicast on the host loopback, build with -DTRANSPORT_UDP
+//
+// Both provide, in namespace Transport:
+//
+//   bool begin();                      bring the link up, the broadcast peer is added
+//   bool addPeer(const uint8_t mac[6]);
+//   void removePeer(const uint8_t mac[6]);
+//   bool send(const uint8_t mac[6], const uint8_t* data, size_t len);
+//   void onReceive(ReceiveCallback cb);
+//   void onSent(SentCallback cb);      once per successful send(), in send order
+//   void poll();                       call from loop()
+//
+// Callbacks may run outside loop() (the WiFi task for ESP-NOW), keep them short.
+
+namespace Transport {
+
+typedef void (*ReceiveCallback)(const uint8_t* mac, const uint8_t* data, int len);
+typedef void (*SentCallback)(bool delivered);
+
+static const uint8_t broadcastMac[6] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+}
+
+#if defined(TRANSPORT_UDP)
+  #include "transport_udp.h"
+#else
+  #include "transport_espnow.h"
+#endif
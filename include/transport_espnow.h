@@ -0,0 +1,83 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_wifi.h>
+#include <esp_now.h>
+#include <cstring>
+#include "message.h"
+
+namespace Transport {
+
+static ReceiveCallback receiveCallback = nullptr;
+static SentCallback sentCallback = nullptr;
+
+// Core 3 passes an esp_now_recv_info_t, core 2 (sari, ifei) the sender's MAC
+template<typename Info>
+static inline const uint8_t* senderOf(const Info* info) {
+  return info->src_addr;
+}
+
+static inline const uint8_t* senderOf(const uint8_t* mac) {
+  return mac;
+}
+
+// The callback signatures are deduced from what the core's register functions expect
+template<typename Info>
+static inline void espNowReceived(const Info* info, const uint8_t* data, int len) {
+  if (receiveCallback) {
+    receiveCallback(senderOf(info), data, len);
+  }
+}
+
+// The first parameter is the destination MAC or a wifi_tx_info_t depending on the core version
+template<typename Info>
+static inline void espNowSent(const Info* info, esp_now_send_status_t status) {
+  if (sentCallback) {
+    sentCallback(status == ESP_NOW_SEND_SUCCESS);
+  }
+}
+
+static inline bool addPeer(const uint8_t mac[6]) {
+  if (esp_now_is_peer_exist(mac)) {
+    return true;
+  }
+  esp_now_peer_info_t peer{};
+  memcpy(peer.peer_addr, mac, 6);
+  peer.channel = 0;
+  peer.encrypt = false;
+  return esp_now_add_peer(&peer) == ESP_OK;
+}
+
+static inline void removePeer(const uint8_t mac[6]) {
+  esp_now_del_peer(mac);
+}
+
+static inline bool begin() {
+  WiFi.mode(WIFI_STA);
+  esp_wifi_set_channel(ESP_CHANNEL, WIFI_SECOND_CHAN_NONE);
+  esp_wifi_set_max_tx_power(ESP_MAX_TX_POWER);
+  if (esp_now_init() != ESP_OK) {
+    return false;
+  }
+  esp_now_register_recv_cb(espNowReceived);
+  esp_now_register_send_cb(espNowSent);
+  return addPeer(broadcastMac);
+}
+
+static inline bool send(const uint8_t mac[6], const uint8_t* data, size_t len) {
+  return esp_now_send(mac, data, len) == ESP_OK;
+}
+
+static inline void onReceive(ReceiveCallback cb) {
+  receiveCallback = cb;
+}
+
+static inline void onSent(SentCallback cb) {
+  sentCallback = cb;
+}
+
+static inline void poll() {
+}
+
+}
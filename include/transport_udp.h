@@ -0,0 +1,134 @@
+#pragma once
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include "message.h"
+
+// Every process joins one multicast group on the loopback interface, which stands in for the
+// radio channel. Datagrams carry [destination MAC][source MAC][frame]; each process makes up a
+// locally administered MAC and drops frames addressed to someone else, as the radio would.
+// There is no link layer acknowledgement: a unicast counts as delivered once it was sent.
+
+#ifndef TRANSPORT_UDP_GROUP
+  #define TRANSPORT_UDP_GROUP "239.255.72.18"
+#endif
+
+#ifndef TRANSPORT_UDP_PORT
+  #define TRANSPORT_UDP_PORT 47218
+#endif
+
+namespace Transport {
+
+static ReceiveCallback receiveCallback = nullptr;
+static SentCallback sentCallback = nullptr;
+static int udpSocket = -1;
+static uint8_t localMac[6];
+
+// Host tools (hub_replay) use it to see every frame that went out
+static void (*sendObserver)(const uint8_t* mac, const uint8_t* data, size_t len) = nullptr;
+
+// Every datagram is a broadcast here, there are no peers to keep
+static inline bool addPeer(const uint8_t /* mac */[6]) {
+  return true;
+}
+
+static inline void removePeer(const uint8_t /* mac */[6]) {
+}
+
+static inline bool begin() {
+  udpSocket = socket(AF_INET, SOCK_DGRAM, 0);
+  if (udpSocket < 0) {
+    return false;
+  }
+  const int on = 1;
+  setsockopt(udpSocket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  setsockopt(udpSocket, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+
+  sockaddr_in local{};
+  local.sin_family = AF_INET;
+  local.sin_port = htons(TRANSPORT_UDP_PORT);
+  local.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(udpSocket, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0) {
+    return false;
+  }
+
+  ip_mreq group{};
+  group.imr_multiaddr.s_addr = inet_addr(TRANSPORT_UDP_GROUP);
+  group.imr_interface.s_addr = htonl(INADDR_LOOPBACK);
+  if (setsockopt(udpSocket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &group, sizeof(group)) != 0) {
+    return false;
+  }
+  in_addr loopback{};
+  loopback.s_addr = htonl(INADDR_LOOPBACK);
+  setsockopt(udpSocket, IPPROTO_IP, IP_MULTICAST_IF, &loopback, sizeof(loopback));
+  const unsigned char loop = 1, ttl = 0;
+  setsockopt(udpSocket, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+  setsockopt(udpSocket, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+  fcntl(udpSocket, F_SETFL, fcntl(udpSocket, F_GETFL) | O_NONBLOCK);
+
+  srand((unsigned)getpid() ^ (unsigned)time(nullptr));
+  localMac[0] = 0x02;
+  for (size_t i = 1; i < sizeof(localMac); i++) {
+    localMac[i] = (uint8_t)rand();
+  }
+  return true;
+}
+
+static inline bool send(const uint8_t mac[6], const uint8_t* data, size_t len) {
+  if (udpSocket < 0 || len > MAX_FRAME_SIZE) {
+    return false;
+  }
+  uint8_t datagram[12 + MAX_FRAME_SIZE];
+  memcpy(datagram, mac, 6);
+  memcpy(datagram + 6, localMac, 6);
+  memcpy(datagram + 12, data, len);
+
+  sockaddr_in to{};
+  to.sin_family = AF_INET;
+  to.sin_port = htons(TRANSPORT_UDP_PORT);
+  to.sin_addr.s_addr = inet_addr(TRANSPORT_UDP_GROUP);
+  if (sendto(udpSocket, datagram, 12 + len, 0, reinterpret_cast<sockaddr*>(&to), sizeof(to)) < 0) {
+    return false;
+  }
+  if (sendObserver) {
+    sendObserver(mac, data, len);
+  }
+  if (sentCallback) {
+    sentCallback(true);
+  }
+  return true;
+}
+
+static inline void onReceive(ReceiveCallback cb) {
+  receiveCallback = cb;
+}
+
+static inline void onSent(SentCallback cb) {
+  sentCallback = cb;
+}
+
+static inline void poll() {
+  uint8_t datagram[12 + MAX_FRAME_SIZE];
+  ssize_t n;
+  while (udpSocket >= 0 && (n = recv(udpSocket, datagram, sizeof(datagram), 0)) >= 12) {
+    const uint8_t* to = datagram;
+    const uint8_t* from = datagram + 6;
+    if (memcmp(from, localMac, 6) == 0) {
+      continue; // our own, looped back
+    }
+    if (memcmp(to, broadcastMac, 6) != 0 && memcmp(to, localMac, 6) != 0) {
+      continue;
+    }
+    if (receiveCallback) {
+      receiveCallback(from, datagram + 12, (int)(n - 12));
+    }
+  }
+}
+
+}
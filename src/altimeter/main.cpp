@@ -3,12 +3,15 @@
 // Display_ST77916, esp_lcd_st77916, I2C_Driver from Waveshare demo
 // DCS-BIOS integration for F/A-18C Altimeter
 #include <Arduino.h>
-#include <WiFi.h>
-#include <esp_wifi.h>
-#include <esp_now.h>
 #include <lvgl.h>
 #include "Display_ST77916.h"
 #include "message.h"
+#include "altimeter_codec.h"
+#include "transport.h"
+#include "link_stats.h"
+#include "fec.h"
+#include "subscription.h"
+#include "dead_reckoning.h"
 
 // ===== Bitmaps =====
 #include "altimeterBackground.c"
@@ -48,114 +51,121 @@ const int16_t center_x = DISP_WIDTH / 2;
 const int16_t center_y = DISP_HEIGHT / 2;
 
 // ===== Flush function for LVGL =====
+static LatencyStats latencyStats;
+
 void my_disp_flush(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p) {
   LCD_addWindow(area->x1, area->y1, area->x2, area->y2, (uint16_t*)color_p);
   lv_disp_flush_ready(disp);
+  if (lv_disp_flush_is_last(disp)) {
+    latencyStats.displayed();
+  }
 }
 
-// Needle (0–65535 => 0–360°)
-void onStbyAlt100FtPtrChange(unsigned int newValue) {
-  float angle = (newValue / 65535.0f) * 360.0f;
-  lv_img_set_angle(img_altimeterNeedle, angle * 10); // LVGL uses 0.1° units
-}
-
-void onStbyAlt1000FtCntChange(unsigned int newValue) {
-  float offset = (newValue / 65535.0 * 10 - 9) / 10 * 410;
-  lv_img_set_offset_y(img_altimeterMarquee, (int)offset);
-}
-
-// 10000s drum (0–5)
-void onStbyAlt10000FtCntChange(unsigned int newValue) {
-  int offset10000s = map(newValue, 0, 36407, DIGIT_HEIGHT2 , (DIGIT_HEIGHT2 * 6));
-  lv_img_set_offset_y(img_altimeterMarquee2, offset10000s);
-}
-
-// value: 0.0 - 10.0
-void updateBaroDrum(lv_obj_t *img, float value) {
-  // Round to .5
-  float partial = std::round(value * 2) / 2;
-  float offset = (partial - 9) / 10 * BARO_TOTAL_H;
-  lv_img_set_offset_y(img, (int)offset);
-}
-
-void onStbyPressSet0Change(unsigned int newValue) {
-  updateBaroDrum(img_baroOnes, newValue * 10 / 65535.0f);
+// Needle (one turn per 1000 ft) and the 1000s and 10000s drums
+void onAltitudeChange(int32_t altitude) {
+  lv_img_set_angle(img_altimeterNeedle, altimeterNeedleAngle(altitude)); // LVGL uses 0.1° units
+  lv_img_set_offset_y(img_altimeterMarquee, altimeterThousandsDrum(altitude, DIGIT_HEIGHT) - 9 * DIGIT_HEIGHT);
+  // 10000s drum (0–5)
+  lv_img_set_offset_y(img_altimeterMarquee2, DIGIT_HEIGHT2 + altimeterTenThousandsDrum(altitude, DIGIT_HEIGHT2));
 }
 
-void onStbyPressSet1Change(unsigned int newValue) {
-  updateBaroDrum(img_baroTens, newValue * 10 / 65535.0f);
+// digit: 0 - 9
+void updateBaroDrum(lv_obj_t *img, int digit) {
+  lv_img_set_offset_y(img, (digit - 9) * BARO_TOTAL_H / 10);
 }
 
-void onStbyPressSet2Change(unsigned int newValue) {
-  float thousands = 2;
-  float hundreds = 9;
-  if (newValue < 39321) {
-    thousands = 2;
-    hundreds = 8;
-  } else if (newValue < 52428) {
-    thousands = 2;
-    hundreds = 9;
-  } else if (newValue < 65535) {
-    thousands = 3;
-    hundreds = 0;
-  } else {
-    thousands = 3;
-    hundreds = 1;
-  }
-  updateBaroDrum(img_baroThousands, thousands);
-  updateBaroDrum(img_baroHundreds, hundreds);
+// Hundredths of an inch of mercury
+void onKollsmanChange(uint16_t kollsman) {
+  updateBaroDrum(img_baroThousands, kollsman / 1000 % 10);
+  updateBaroDrum(img_baroHundreds, kollsman / 100 % 10);
+  updateBaroDrum(img_baroTens, kollsman / 10 % 10);
+  updateBaroDrum(img_baroOnes, kollsman % 10);
 }
 
+// Fed by the receive callback (the WiFi task under ESP-NOW) and read by loop(), under msgMux
+static portMUX_TYPE msgMux = portMUX_INITIALIZER_UNLOCKED;
 static AltimeterMessage lastMessage = {};
 uint16_t brightness = 0;
 volatile bool hasNewMessage = false;
 
+// The needle and the drums keep moving between frames
+static DeadReckoner altitude(0, -altitudeRange, altitudeRange);
+
+static bool advanceTrends(uint32_t now) {
+  portENTER_CRITICAL(&msgMux);
+  const bool moved = altitude.update(now);
+  portEXIT_CRITICAL(&msgMux);
+  return moved;
+}
+
 void updateRendering() {
-  onStbyAlt10000FtCntChange(lastMessage.alt10000FtCnt);
-  onStbyAlt1000FtCntChange(lastMessage.alt1000FtCnt);
-  onStbyAlt100FtPtrChange(lastMessage.alt100FtPtr);
-  onStbyPressSet0Change(lastMessage.pressSet0);
-  onStbyPressSet1Change(lastMessage.pressSet1);
-  onStbyPressSet2Change(lastMessage.pressSet2);
+  onAltitudeChange(altitude.position);
+  portENTER_CRITICAL(&msgMux);
+  const uint16_t kollsman = lastMessage.kollsman;
+  portEXIT_CRITICAL(&msgMux);
+  onKollsmanChange(kollsman);
   setBrightness(brightness);
 }
 
-static void initEspNowClient() {
-  WiFi.mode(WIFI_STA);
-  esp_wifi_set_channel(ESP_CHANNEL, WIFI_SECOND_CHAN_NONE);
-  esp_wifi_set_max_tx_power(ESP_MAX_TX_POWER);
-
-  if (esp_now_init() != ESP_OK) {
-    Serial.println("ESP-NOW init failed");
-    return;
-  }
-
-  esp_now_register_recv_cb([](const esp_now_recv_info_t* info, const uint8_t* data, int len) {
-    if (len < (int)sizeof(MessageHeader)) {
+static LinkStats linkStats;
+static FecReceiver fec;
+static SubscriptionAnnouncer subscription(
+  categoryBit(MessageCategory::Altimeter) | categoryBit(MessageCategory::Integer) | categoryBit(MessageCategory::Trend) |
+    categoryBit(MessageCategory::Parity),
+  valueBit(ValueName::InstrumentLighting));
+
+static void onMessage(const uint8_t* data, int len) {
+  const MessageHeader* hdr = reinterpret_cast<const MessageHeader*>(data);
+  IntegerMessage integerMessage;
+  switch (hdr->category) {
+  case MessageCategory::Altimeter:
+    if (len != (int)sizeof(AltimeterMessage)) {
       return;
     }
-
-    const MessageHeader* hdr = reinterpret_cast<const MessageHeader*>(data);
-    IntegerMessage integerMessage;
-    switch (hdr->category) {
-    case MessageCategory::Altimeter:
-      if (len != (int)sizeof(AltimeterMessage)) {
-        return;
+    portENTER_CRITICAL_ISR(&msgMux);
+    lastMessage = *reinterpret_cast<const AltimeterMessage *>(data);
+    altitude.onValue(lastMessage.altitude, millis());
+    portEXIT_CRITICAL_ISR(&msgMux);
+    hasNewMessage = true;
+    break;
+  case MessageCategory::Trend:
+    forEachTrend(data, len, [](TrendField field, int16_t rate) {
+      if (field == TrendField::Altitude) {
+        portENTER_CRITICAL_ISR(&msgMux);
+        altitude.onRate(rate);
+        portEXIT_CRITICAL_ISR(&msgMux);
       }
-      lastMessage = *reinterpret_cast<const AltimeterMessage *>(data);
+    });
+    break;
+  case MessageCategory::Integer:
+    integerMessage = *reinterpret_cast<const IntegerMessage *>(data);
+    if (integerMessage.name == ValueName::InstrumentLighting) {
+      brightness = integerMessage.value;
       hasNewMessage = true;
-      break;
-    case MessageCategory::Integer:
-      integerMessage = *reinterpret_cast<const IntegerMessage *>(data);
-      if (integerMessage.name == ValueName::InstrumentLighting) {
-        brightness = integerMessage.value;
-        hasNewMessage = true;
-      }
-      break;
-    default:
-      break;
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+static void initTransport() {
+  if (!Transport::begin()) {
+    Serial.println("Transport init failed");
+    return;
+  }
+
+  Transport::onReceive([](const uint8_t* mac, const uint8_t* data, int len) {
+    latencyStats.recordFrame(data, len);
+    linkStats.recordFrame(data, len);
+    fec.recordFrame(data, len, onMessage);
+    forEachMessage(data, len, onMessage);
+    if (hasNewMessage) {
+      latencyStats.markPending();
     }
   });
+  subscription.begin();
+  latencyStats.begin();
 }
 
 void setup() {
@@ -276,15 +286,17 @@ void setup() {
   // Place pivot exactly at gauge center
   lv_obj_set_pos(img_altimeterNeedle, center_x - pivot.x, center_y - pivot.y);
 
-  updateBaroDrum(img_baroThousands, 2);
-  updateBaroDrum(img_baroHundreds, 9);
-  updateBaroDrum(img_baroTens, 9);
-  updateBaroDrum(img_baroOnes, 2);
+  onKollsmanChange(2992);
 
-  initEspNowClient();
+  initTransport();
 }
 
 void loop() {
+  Transport::poll();
+  linkStats.serviceConsole(Serial, &latencyStats, &fec);
+  subscription.service(millis());
+  latencyStats.service(millis());
+
   static uint32_t lastTick = millis();
   const uint32_t now = millis();
   uint32_t dt = now - lastTick;
@@ -293,7 +305,7 @@ void loop() {
   lv_tick_inc(dt);
 
   static uint32_t lastUpdatedAt = 0;
-  if (now - lastUpdatedAt > 40 && hasNewMessage) {
+  if (now - lastUpdatedAt > 40 && (advanceTrends(now) || hasNewMessage)) {
     hasNewMessage = false;
     lastUpdatedAt = now;
     updateRendering();
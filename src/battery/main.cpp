@@ -9,12 +9,12 @@ Key stability changes:
 */
 
 #include <Arduino.h>
-#include <WiFi.h>
-#include <esp_wifi.h>
-#include <esp_now.h>
 #include <TFT_eSPI.h>
 #include "TFT_helper.h"
 #include "message.h"
+#include "transport.h"
+#include "link_stats.h"
+#include "subscription.h"
 
 #include "BatteryBackground.h" // uint16_t Battery[240*240]
 #include "Needle.h"            // uint16_t Needle[15*88]
@@ -44,46 +44,55 @@ static inline int16_t map_e(uint16_t v) { return map(v, 0, 65535,  150,  30); }
 void renderGauge(int16_t angleU, int16_t angleE);
 void bitTest();
 
-static void initEspNowClient() {
-  WiFi.mode(WIFI_STA);
-  esp_wifi_set_channel(ESP_CHANNEL, WIFI_SECOND_CHAN_NONE);
-  esp_wifi_set_max_tx_power(ESP_MAX_TX_POWER);
-
-  if (esp_now_init() != ESP_OK) {
-    Serial.println("ESP-NOW init failed");
+static LinkStats linkStats;
+static LatencyStats latencyStats;
+static SubscriptionAnnouncer subscription(
+  categoryBit(MessageCategory::Integer),
+  valueBit(ValueName::VoltU) | valueBit(ValueName::VoltE) | valueBit(ValueName::ConsoleLighting));
+
+static void onMessage(const uint8_t* data, int len) {
+  const MessageHeader* hdr = reinterpret_cast<const MessageHeader*>(data);
+  IntegerMessage message{};
+  switch (hdr->category) {
+  case MessageCategory::Integer:
+    if (len != (int)sizeof(IntegerMessage)) {
+      return;
+    }
+    message = *reinterpret_cast<const IntegerMessage *>(data);
+    if (message.name == ValueName::VoltE) {
+      rawE = message.value;
+      dirty = true;
+    }
+    if (message.name == ValueName::VoltU) {
+      rawU = message.value;
+      dirty = true;
+    }
+    if (message.name == ValueName::ConsoleLighting) {
+      brightness = message.value;
+      dirty = true;
+    }
+    break;
+  default:
     return;
   }
+}
 
-  esp_now_register_recv_cb([](const esp_now_recv_info_t* info, const uint8_t* data, int len) {
-    if (len < (int)sizeof(MessageHeader)) {
-      return;
-    }
+static void initTransport() {
+  if (!Transport::begin()) {
+    Serial.println("Transport init failed");
+    return;
+  }
 
-    const MessageHeader* hdr = reinterpret_cast<const MessageHeader*>(data);
-    IntegerMessage message{};
-    switch (hdr->category) {
-    case MessageCategory::Integer:
-      if (len != (int)sizeof(IntegerMessage)) {
-        return;
-      }
-      message = *reinterpret_cast<const IntegerMessage *>(data);
-      if (message.name == ValueName::VoltE) {
-        rawE = message.value;
-        dirty = true;
-      }
-      if (message.name == ValueName::VoltE) {
-        rawU = message.value;
-        dirty = true;
-      }
-      if (message.name == ValueName::ConsoleLighting) {
-        brightness = message.value;
-        dirty = true;
-      }
-      break;
-    default:
-      return;
+  Transport::onReceive([](const uint8_t* mac, const uint8_t* data, int len) {
+    latencyStats.recordFrame(data, len);
+    linkStats.recordFrame(data, len);
+    forEachMessage(data, len, onMessage);
+    if (dirty) {
+      latencyStats.markPending();
     }
   });
+  subscription.begin();
+  latencyStats.begin();
 }
 
 // ── Setup ──────────────────────────────────────────────────────────────────────
@@ -117,11 +126,16 @@ void setup() {
   // First paint
   renderGauge(map_u(rawU), map_e(rawE));
 
-  initEspNowClient();
+  initTransport();
 }
 
 // ── Main loop ──────────────────────────────────────────────────────────────────
 void loop() {
+  Transport::poll();
+  linkStats.serviceConsole(Serial, &latencyStats);
+  subscription.service(millis());
+  latencyStats.service(millis());
+
   const uint32_t now = millis();
   const bool frameDue = (now - lastFrameMs) >= FRAME_INTERVAL_MS;
 
@@ -154,6 +168,7 @@ void renderGauge(int16_t angleU, int16_t angleE) {
 
   // Push full frame to screen
   gaugeBack.pushSprite(0, 0);
+  latencyStats.displayed();
 }
 
 // ── Optional: range test (manual BIT) ──────────────────────────────────────────
@@ -8,12 +8,12 @@ Stable ISR-safe version:
 - 30 FPS render throttle + watchdog keeps screen alive while DCS active
 */
 #include <Arduino.h>
-#include <WiFi.h>
-#include <esp_wifi.h>
-#include <esp_now.h>
 #include <TFT_eSPI.h>
 #include "TFT_helper.h"
 #include "message.h"
+#include "transport.h"
+#include "link_stats.h"
+#include "subscription.h"
 
 #include "brakePressBackground.h"  // uint16_t brakePressBackground[240*240]
 #include "brakePressNeedle.h"      // uint16_t brakePressNeedle[15*150]
@@ -44,43 +44,52 @@ static inline int16_t mapBrakeValue(uint16_t v) {
 void renderGauge(int16_t angleDeg);
 void bitTest();
 
-static void initEspNowClient() {
-  WiFi.mode(WIFI_STA);
-  esp_wifi_set_channel(ESP_CHANNEL, WIFI_SECOND_CHAN_NONE);
-  esp_wifi_set_max_tx_power(ESP_MAX_TX_POWER);
-
-  if (esp_now_init() != ESP_OK) {
-    Serial.println("ESP-NOW init failed");
+static LinkStats linkStats;
+static LatencyStats latencyStats;
+static SubscriptionAnnouncer subscription(
+  categoryBit(MessageCategory::Integer),
+  valueBit(ValueName::BrakePressure) | valueBit(ValueName::InstrumentLighting));
+
+static void onMessage(const uint8_t* data, int len) {
+  const MessageHeader* hdr = reinterpret_cast<const MessageHeader*>(data);
+  IntegerMessage message{};
+  switch (hdr->category) {
+  case MessageCategory::Integer:
+    if (len != (int)sizeof(IntegerMessage)) {
+      return;
+    }
+    message = *reinterpret_cast<const IntegerMessage *>(data);
+    if (message.name == ValueName::BrakePressure) {
+      pressure = message.value;
+      dirtyBrake = true;
+    }
+    if (message.name == ValueName::InstrumentLighting) {
+      brightness = message.value;
+      dirtyBrake = true;
+    }
+    break;
+  default:
+    // ignore
     return;
   }
+}
 
-  esp_now_register_recv_cb([](const esp_now_recv_info_t* info, const uint8_t* data, int len) {
-    if (len < (int)sizeof(MessageHeader)) {
-      return;
-    }
+static void initTransport() {
+  if (!Transport::begin()) {
+    Serial.println("Transport init failed");
+    return;
+  }
 
-    const MessageHeader* hdr = reinterpret_cast<const MessageHeader*>(data);
-    IntegerMessage message{};
-    switch (hdr->category) {
-    case MessageCategory::Integer:
-      if (len != (int)sizeof(IntegerMessage)) {
-        return;
-      }
-      message = *reinterpret_cast<const IntegerMessage *>(data);
-      if (message.name == ValueName::BrakePressure) {
-        pressure = message.value;
-        dirtyBrake = true;
-      }
-      if (message.name == ValueName::InstrumentLighting) {
-        brightness = message.value;
-        dirtyBrake = true;
-      }
-      break;
-    default:
-      // ignore
-      return;
+  Transport::onReceive([](const uint8_t* mac, const uint8_t* data, int len) {
+    latencyStats.recordFrame(data, len);
+    linkStats.recordFrame(data, len);
+    forEachMessage(data, len, onMessage);
+    if (dirtyBrake) {
+      latencyStats.markPending();
     }
   });
+  subscription.begin();
+  latencyStats.begin();
 }
 
 void setup() {
@@ -105,12 +114,17 @@ void setup() {
 
   renderGauge(mapBrakeValue(pressure));
 
-  initEspNowClient();
+  initTransport();
   // bitTest();   // optional boot-time sweep
 }
 
 // ── Main loop ──────────────────────────────────────────────────────────────────
 void loop() {
+  Transport::poll();
+  linkStats.serviceConsole(Serial, &latencyStats);
+  subscription.service(millis());
+  latencyStats.service(millis());
+
   const uint32_t now = millis();
   const bool frameDue = (now - lastFrameMs) >= FRAME_INTERVAL_MS;
 
@@ -135,6 +149,7 @@ void renderGauge(int16_t angleDeg) {
   sprBack.pushImage(0, 0, CANVAS_W, CANVAS_H, brakePressBackground);
   sprNeedle.pushRotated(&sprBack, angleDeg, TFT_TRANSPARENT);
   sprBack.pushSprite(0, 0);
+  latencyStats.displayed();
 }
 
 // ── Manual sweep test ──────────────────────────────────────────────────────────
@@ -1,10 +1,10 @@
 #include <Arduino.h>
-#include <WiFi.h>
-#include <esp_wifi.h>
-#include <esp_now.h>
 #include <lvgl.h>
 #include "Display_ST77916.h"
 #include "message.h"
+#include "transport.h"
+#include "link_stats.h"
+#include "subscription.h"
 
 #include "cabinPressureBG.c"
 #include "cabinPressureNeedle.c"
@@ -24,9 +24,14 @@ lv_obj_t *imgNeedle;
 const int16_t center_x = DISP_WIDTH / 2;
 const int16_t center_y = DISP_HEIGHT / 2;
 
+static LatencyStats latencyStats;
+
 void my_disp_flush(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p) {
   LCD_addWindow(area->x1, area->y1, area->x2, area->y2, (uint16_t*)color_p);
   lv_disp_flush_ready(disp);
+  if (lv_disp_flush_is_last(disp)) {
+    latencyStats.displayed();
+  }
 }
 
 bool hasNewMessage = false;
@@ -38,42 +43,50 @@ void updateRendering() {
   setBrightness(brightness);
 }
 
-static void initEspNowClient() {
-  WiFi.mode(WIFI_STA);
-  esp_wifi_set_channel(ESP_CHANNEL, WIFI_SECOND_CHAN_NONE);
-  esp_wifi_set_max_tx_power(ESP_MAX_TX_POWER);
+static LinkStats linkStats;
+static SubscriptionAnnouncer subscription(
+  categoryBit(MessageCategory::Integer),
+  valueBit(ValueName::CabinAltitudeIndicator) | valueBit(ValueName::InstrumentLighting));
+
+static void onMessage(const uint8_t* data, int len) {
+  const MessageHeader* hdr = reinterpret_cast<const MessageHeader*>(data);
+  IntegerMessage message{};
+  switch (hdr->category) {
+  case MessageCategory::Integer:
+    if (len != (int)sizeof(IntegerMessage)) {
+      return;
+    }
+    message = *reinterpret_cast<const IntegerMessage *>(data);
+    if (message.name == ValueName::CabinAltitudeIndicator) {
+      lastMessage = message;
+      hasNewMessage = true;
+    }
+    if (message.name == ValueName::InstrumentLighting) {
+      brightness = message.value;
+      hasNewMessage = true;
+    }
+    break;
+  default:
+    break;
+  }
+}
 
-  if (esp_now_init() != ESP_OK) {
-    Serial.println("ESP-NOW init failed");
+static void initTransport() {
+  if (!Transport::begin()) {
+    Serial.println("Transport init failed");
     return;
   }
 
-  esp_now_register_recv_cb([](const esp_now_recv_info_t* info, const uint8_t* data, int len) {
-    if (len < (int)sizeof(MessageHeader)) {
-      return;
-    }
-
-    const MessageHeader* hdr = reinterpret_cast<const MessageHeader*>(data);
-    IntegerMessage message{};
-    switch (hdr->category) {
-    case MessageCategory::Integer:
-      if (len != (int)sizeof(IntegerMessage)) {
-        return;
-      }
-      message = *reinterpret_cast<const IntegerMessage *>(data);
-      if (message.name == ValueName::CabinAltitudeIndicator) {
-        lastMessage = message;
-        hasNewMessage = true;
-      }
-      if (message.name == ValueName::InstrumentLighting) {
-        brightness = message.value;
-        hasNewMessage = true;
-      }
-      break;
-    default:
-      break;
+  Transport::onReceive([](const uint8_t* mac, const uint8_t* data, int len) {
+    latencyStats.recordFrame(data, len);
+    linkStats.recordFrame(data, len);
+    forEachMessage(data, len, onMessage);
+    if (hasNewMessage) {
+      latencyStats.markPending();
     }
   });
+  subscription.begin();
+  latencyStats.begin();
 }
 
 void setup() {
@@ -126,10 +139,15 @@ void setup() {
   lv_obj_align(imgNeedle, LV_ALIGN_CENTER, 0, 0);
   lv_img_set_angle(imgNeedle, 1800); // The needle image is upwards
 
-  initEspNowClient();
+  initTransport();
 }
 
 void loop() {
+  Transport::poll();
+  linkStats.serviceConsole(Serial, &latencyStats);
+  subscription.service(millis());
+  latencyStats.service(millis());
+
   static uint32_t lastTick = millis();
   const uint32_t now = millis();
   uint32_t dt = now - lastTick;
@@ -0,0 +1,134 @@
+// Plays frame logs (include/frame_log.h) back through the UDP transport with their recorded
+// timing, as if the hub were sending them: sorties taken by the hub's flight recorder
+// (src/hub/flight_recorder.h) or by hub_replay --frames become repeatable workloads for
+// gauge_monitor and protocol changes, without DCS.
+//
+//   pio run -e frame_injector
+//   .pio/build/frame_injector/program sortie.hfl [more.hfl ...] [--speed 1] [--loop]
+//
+// Each frame is due at its recorded offset from the first one, divided by --speed, against a
+// fixed start time, so a late frame does not shift the ones after it. Clock pongs answered a
+// live exchange and are skipped. Logs given together are played back to back.
+//
+// Unicast replay is approximate: the log does not keep the destination, so the hub's unicast
+// frames to subscribed gauges go out as broadcasts and reach every gauge listening.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "message.h"
+#include "transport.h"
+#include "frame_log.h"
+
+struct LoggedFrame {
+  uint32_t ms;
+  std::vector<uint8_t> data;
+};
+
+static bool readLog(const char* path, std::vector<LoggedFrame>& frames) {
+  FILE* f = fopen(path, "rb");
+  if (!f) {
+    return false;
+  }
+  char magic[FRAME_LOG_MAGIC_SIZE];
+  if (fread(magic, 1, sizeof(magic), f) != sizeof(magic) || memcmp(magic, FRAME_LOG_MAGIC, sizeof(magic)) != 0) {
+    fclose(f);
+    return false;
+  }
+
+  // Logs are concatenated on one timeline, a clock that went back starts a new stretch
+  const uint32_t base = frames.empty() ? 0 : frames.back().ms + 1;
+  uint32_t first = 0;
+  bool seen = false;
+  FrameLogRecord record;
+  while (fread(&record, sizeof(record), 1, f) == 1) {
+    LoggedFrame frame;
+    frame.data.resize(record.len);
+    if (fread(frame.data.data(), 1, record.len, f) != record.len) {
+      break; // cut short by a power loss, the rest is gone
+    }
+    if (!seen) {
+      first = record.ms;
+      seen = true;
+    }
+    frame.ms = base + (record.ms - first);
+    frames.push_back(std::move(frame));
+  }
+  fclose(f);
+  return true;
+}
+
+static void usage() {
+  fprintf(stderr, "usage: frame_injector log.hfl [more.hfl ...] [--speed 1] [--loop]\n");
+}
+
+int main(int argc, char** argv) {
+  std::vector<LoggedFrame> frames;
+  double speed = 1.0;
+  bool loop = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+      speed = atof(argv[++i]);
+      if (speed <= 0) {
+        usage();
+        return 2;
+      }
+    } else if (strcmp(argv[i], "--loop") == 0) {
+      loop = true;
+    } else if (argv[i][0] != '-') {
+      if (!readLog(argv[i], frames)) {
+        fprintf(stderr, "cannot read frame log %s\n", argv[i]);
+        return 1;
+      }
+    } else {
+      usage();
+      return 2;
+    }
+  }
+  if (frames.empty()) {
+    usage();
+    return 2;
+  }
+
+  if (!Transport::begin()) {
+    perror("transport");
+    return 1;
+  }
+
+  uint64_t sent = 0;
+  uint64_t bytes = 0;
+  int64_t worstLateUs = 0;
+  int64_t totalLateUs = 0;
+  do {
+    const auto start = std::chrono::steady_clock::now();
+    const uint32_t first = frames.front().ms;
+    for (const LoggedFrame& frame : frames) {
+      if (frame.data.size() >= sizeof(MessageHeader) &&
+          reinterpret_cast<const MessageHeader*>(frame.data.data())->category == MessageCategory::ClockPong) {
+        continue;
+      }
+      const auto due = start + std::chrono::microseconds((int64_t)((frame.ms - first) * 1000.0 / speed));
+      std::this_thread::sleep_until(due);
+      Transport::send(Transport::broadcastMac, frame.data.data(), frame.data.size());
+      Transport::poll(); // nothing is answered, keeps the socket drained
+
+      const int64_t lateUs =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - due).count();
+      worstLateUs = std::max(worstLateUs, lateUs);
+      totalLateUs += lateUs;
+      sent++;
+      bytes += frame.data.size();
+    }
+  } while (loop);
+
+  const double seconds = (frames.back().ms - frames.front().ms) / 1000.0 / speed;
+  printf("injected     %llu frames, %llu bytes over %.1f s\n", (unsigned long long)sent,
+         (unsigned long long)bytes, seconds);
+  printf("timing       %.3f ms mean, %.3f ms worst behind schedule\n",
+         sent ? totalLateUs / 1000.0 / sent : 0.0, worstLateUs / 1000.0);
+  return 0;
+}
@@ -0,0 +1,188 @@
+// Host stand-in for a gauge on the UDP transport (include/transport_udp.h). It subscribes to
+// everything, runs the message handling the gauges share (superframes, IFEI keyframes and
+// deltas, trends, clock sync, parity) and reports throughput, losses and hub-to-gauge latency.
+// --drop discards that percentage of received frames at random, to watch parity recover them.
+//
+//   pio run -e gauge_monitor
+//   .pio/build/gauge_monitor/program [--seconds 30] [--drop 0]
+//
+// Start one or more monitors, then the hub_udp harness (see src/hub_replay/main.cpp).
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "message.h"
+#include "transport.h"
+#include "ifei_codec.h"
+#include "attitude_codec.h"
+#include "dead_reckoning.h"
+#include "link_stats.h"
+#include "fec.h"
+#include "subscription.h"
+
+static LinkStats linkStats;
+static LatencyStats latencyStats;
+static FecReceiver fec;
+static SubscriptionAnnouncer subscription(0xFFFFFFFF, 0xFFFF);
+
+static IfeiMessage ifei{};
+static SaiMessage saiBase{};
+static SaiMessage sai{};
+static uint32_t attitudeWithoutBase = 0;
+static uint32_t ifeiWithoutBase = 0;
+static uint16_t values[valueNameCount];
+static uint32_t framesReceived = 0;
+static uint64_t bytesReceived = 0;
+static uint32_t messagesHandled = 0;
+static uint32_t messagesRejected = 0;
+static int dropPercent = 0;
+static uint32_t framesDropped = 0;
+
+static void onMessage(const uint8_t* data, int len) {
+  const MessageHeader* hdr = reinterpret_cast<const MessageHeader*>(data);
+  bool handled = true;
+  switch (hdr->category) {
+  case MessageCategory::IFEI:
+    handled = deserializeMessage(data, len, ifei);
+    break;
+  case MessageCategory::IFEICompact: {
+    IfeiCompactMessage m;
+    handled = deserializeMessage(data, len, m);
+    if (handled) {
+      decodeIfeiCompact(m, ifei);
+    }
+    break;
+  }
+  case MessageCategory::IFEIDelta: {
+    uint16_t baseMs = 0;
+    const bool complete = len >= (int)offsetof(IfeiDeltaMessage, payload);
+    if (complete) {
+      memcpy(&baseMs, data + offsetof(IfeiDeltaMessage, baseMs), sizeof(baseMs));
+    }
+    handled = applyIfeiDelta(ifei, data, len);
+    if (!handled && complete && baseMs != (uint16_t)ifei.header.ms) {
+      ifeiWithoutBase++;
+      handled = true;
+    }
+    break;
+  }
+  case MessageCategory::Integer: {
+    IntegerMessage m;
+    handled = deserializeMessage(data, len, m) && static_cast<size_t>(m.name) < valueNameCount;
+    if (handled) {
+      values[static_cast<size_t>(m.name)] = m.value;
+    }
+    break;
+  }
+  case MessageCategory::SAI:
+    handled = deserializeMessage(data, len, saiBase);
+    if (handled) {
+      sai = saiBase;
+    }
+    break;
+  case MessageCategory::Attitude: {
+    AttitudeMessage m;
+    handled = deserializeMessage(data, len, m);
+    if (handled && !decodeAttitude(m, saiBase, sai)) {
+      attitudeWithoutBase++;
+    }
+    break;
+  }
+  case MessageCategory::Telemetry: {
+    TelemetryMessage m;
+    handled = deserializeMessage(data, len, m);
+    break;
+  }
+  case MessageCategory::Trend:
+    handled = forEachTrend(data, len, [](TrendField, int16_t) {});
+    break;
+  default:
+    break;
+  }
+  if (handled) {
+    messagesHandled++;
+  } else {
+    messagesRejected++;
+  }
+}
+
+static void usage() {
+  fprintf(stderr, "usage: gauge_monitor [--seconds 30] [--drop 0]\n");
+}
+
+int main(int argc, char** argv) {
+  uint32_t seconds = 30;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+      seconds = (uint32_t)std::max(1, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--drop") == 0 && i + 1 < argc) {
+      dropPercent = std::min(100, std::max(0, atoi(argv[++i])));
+    } else {
+      usage();
+      return 2;
+    }
+  }
+
+  ReplayHost::realtime = true;
+  ReplayHost::startWallClock();
+  if (!Transport::begin()) {
+    perror("transport");
+    return 1;
+  }
+  Transport::onReceive([](const uint8_t* /* mac */, const uint8_t* data, int len) {
+    if (rand() % 100 < dropPercent) {
+      framesDropped++;
+      return;
+    }
+    framesReceived++;
+    bytesReceived += len;
+    latencyStats.recordFrame(data, len);
+    linkStats.recordFrame(data, len);
+    fec.recordFrame(data, len, onMessage);
+    forEachMessage(data, len, onMessage);
+  });
+  subscription.begin();
+  latencyStats.begin();
+
+  Print out;
+  uint32_t reportedAt = 0;
+  uint32_t reportedFrames = 0;
+  uint64_t reportedBytes = 0;
+  while (millis() < seconds * 1000) {
+    ReplayHost::nowMs = (uint32_t)(ReplayHost::wallMicros() / 1000);
+    const uint32_t now = millis();
+    Transport::poll();
+    subscription.service(now);
+    latencyStats.service(now);
+
+    if (now - reportedAt >= 1000) {
+      printf("%3us  %5u frames/s  %7llu bytes/s\n", (unsigned)(now / 1000),
+             (unsigned)(framesReceived - reportedFrames), (unsigned long long)(bytesReceived - reportedBytes));
+      reportedAt = now;
+      reportedFrames = framesReceived;
+      reportedBytes = bytesReceived;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+
+  printf("\nreceived     %u frames, %llu bytes, %u messages handled, %u rejected\n", (unsigned)framesReceived,
+         (unsigned long long)bytesReceived, (unsigned)messagesHandled, (unsigned)messagesRejected);
+  if (ifeiWithoutBase) {
+    printf("ifei         %u deltas dropped, their base was lost\n", (unsigned)ifeiWithoutBase);
+  }
+  if (attitudeWithoutBase) {
+    printf("attitude     %u deltas dropped, their base SaiMessage was lost\n", (unsigned)attitudeWithoutBase);
+  }
+  if (dropPercent) {
+    printf("dropped      %u frames on purpose (--drop %d)\n", (unsigned)framesDropped, dropPercent);
+  }
+  printf("\n");
+  linkStats.print(out);
+  fec.print(out);
+  printf("\n");
+  latencyStats.print(out);
+  return 0;
+}
@@ -4,487 +4,424 @@
 #define DCSBIOS_DEFAULT_SERIAL
 #define DCSBIOS_DISABLE_SERVO
 #include <DcsBios.h>
+#include <atomic>
+#include <cstddef>
 #include "message.h"
+#include "altimeter_codec.h"
+
+// Everything the hub knows about the cockpit, filled in by the export table below
+struct CockpitState {
+  MissionType missionType = MissionType::Other;
+  AltimeterDrums altimeter{};
+  RadarAltimeterMessage radarAltimeter{};
+  IfeiMessage ifei{};
+  SaiMessage sai{};
+  uint16_t airspeed = 0;
+  uint16_t vsi = 65535 / 2;
+  uint16_t voltU = 0;
+  uint16_t voltE = 0;
+  uint16_t hydIndBrake = 0;
+  uint16_t cabinAltIndicator = 0;
+  uint16_t hydPressL = 0;
+  uint16_t hydPressR = 0;
+  uint16_t instrumentLighting = 0;
+  uint16_t consoleLighting = 0;
+};
+
+static CockpitState cockpit{};
+
+// Hands the latest complete export frame from the parser to loop() without locks, they run on
+// different cores (ingest.h). Three slots: the writer fills its own and swaps it with the shared
+// one, the reader swaps the shared one for its own when it holds a fresh frame. Neither side
+// ever waits or sees a half written frame; frames the reader did not get to are dropped.
+template<typename T>
+class SnapshotExchange {
+public:
+  T& back() {
+    return slots[backIndex];
+  }
 
-static MissionType missionType = MissionType::Other;
-static AltimeterMessage altimeter{};
-static RadarAltimeterMessage radarAltimeter{};
-static IfeiMessage ifei{};
-static SaiMessage sai{};
-static uint16_t airspeed;
-static uint16_t vsi;
-static uint16_t voltU;
-static uint16_t voltE;
-static uint16_t hydIndBrake;
-static uint16_t cabinAltIndicator;
-static uint16_t hydPressL;
-static uint16_t hydPressR;
-static uint16_t instrumentLighting;
-static uint16_t consoleLighting;
-
-int16_t parse16(const char *s);
-int8_t parse8(const char *s);
-
-void reset() {
-  altimeter = AltimeterMessage{};
-  radarAltimeter = RadarAltimeterMessage{};
-  ifei = IfeiMessage{};
-  sai = SaiMessage{};
-  airspeed = 0;
-  vsi = 65535 / 2;
-  voltU = 0;
-  voltE = 0;
-  hydIndBrake = 0;
-  cabinAltIndicator = 0;
-  hydPressL = 0;
-  hydPressR = 0;
-  instrumentLighting = 0;
-  consoleLighting = 0;
-}
-
-#pragma region DCS Common Data
-void onAcftNameBufferChange(char* newValue) {
-  reset();
-  missionType = strcmp(newValue, "FA-18C_hornet") == 0 ? MissionType::Hornet : MissionType::Other;
-}
-DcsBios::StringBuffer<16> AcftNameBuffer(MetadataStart_ACFT_NAME_A, onAcftNameBufferChange);
-
-void onCockkpitLightModeSwChange(unsigned int newValue) {
-  // TODO: other common message other than IFEI
-  ifei.colorMode = newValue;
-}
-DcsBios::IntegerBuffer cockkpitLightModeSwBuffer(FA_18C_hornet_COCKKPIT_LIGHT_MODE_SW, onCockkpitLightModeSwChange);
-
-void onInstrIntLtChange(unsigned int newValue) {
-  instrumentLighting = newValue;
-}
-DcsBios::IntegerBuffer instrIntLtBuffer(FA_18C_hornet_INSTR_INT_LT, onInstrIntLtChange);
-
-void onConsoleIntLtChange(unsigned int newValue) {
-  consoleLighting = newValue;
-}
-DcsBios::IntegerBuffer consoleIntLtBuffer(FA_18C_hornet_CONSOLE_INT_LT, onConsoleIntLtChange);
-#pragma endregion DCS Common Data
-
-#pragma region Airspeed
-void onStbyAsiAirspeedChange(unsigned int newValue) {
-  airspeed = newValue;
-}
-DcsBios::IntegerBuffer stbyAsiAirspeedBuffer(FA_18C_hornet_STBY_ASI_AIRSPEED, onStbyAsiAirspeedChange);
-#pragma endregion Airspeed
-
-#pragma region Altimeter
-void onStbyAlt100FtPtrChange(unsigned int newValue) {
-  altimeter.alt100FtPtr = newValue;
-}
-DcsBios::IntegerBuffer stbyAlt100FtPtrBuffer(FA_18C_hornet_STBY_ALT_100_FT_PTR, onStbyAlt100FtPtrChange);
-
-void onStbyAlt1000FtCntChange(unsigned int newValue) {
-  altimeter.alt1000FtCnt = newValue;
-}
-DcsBios::IntegerBuffer stbyAlt1000FtCntBuffer(FA_18C_hornet_STBY_ALT_1000_FT_CNT, onStbyAlt1000FtCntChange);
-
-void onStbyAlt10000FtCntChange(unsigned int newValue) {
-  altimeter.alt10000FtCnt = newValue;
-}
-DcsBios::IntegerBuffer stbyAlt10000FtCntBuffer(FA_18C_hornet_STBY_ALT_10000_FT_CNT, onStbyAlt10000FtCntChange);
-
-void onStbyPressSet0Change(unsigned int newValue) {
-  altimeter.pressSet0 = newValue;
-}
-DcsBios::IntegerBuffer stbyPressSet0Buffer(FA_18C_hornet_STBY_PRESS_SET_0, onStbyPressSet0Change);
-
-void onStbyPressSet1Change(unsigned int newValue) {
-  altimeter.pressSet1 = newValue;
-}
-DcsBios::IntegerBuffer stbyPressSet1Buffer(FA_18C_hornet_STBY_PRESS_SET_1, onStbyPressSet1Change);
-
-void onStbyPressSet2Change(unsigned int newValue) {
-  altimeter.pressSet2 = newValue;
-}
-DcsBios::IntegerBuffer stbyPressSet2Buffer(FA_18C_hornet_STBY_PRESS_SET_2, onStbyPressSet2Change);
-#pragma endregion Altimeter
-
-#pragma region Vertical Velocity Indicator
-void onVsiChange(unsigned int newValue) {
-  vsi = newValue;
-}
-DcsBios::IntegerBuffer vsiBuffer(FA_18C_hornet_VSI, onVsiChange);
-#pragma endregion Vertical Velocity Indicator
-
-#pragma region Battery Voltage
-void onVoltUChange(unsigned int v) {
-  voltU = v;
-}
-DcsBios::IntegerBuffer voltUBuffer(FA_18C_hornet_VOLT_U, onVoltUChange);
-
-void onVoltEChange(unsigned int v) {
-  voltE = v;
-}
-DcsBios::IntegerBuffer voltEBuffer(FA_18C_hornet_VOLT_E, onVoltEChange);
-#pragma endregion Battery Voltage
-
-#pragma region Brake Pressure
-void onHydIndBrakeChange(unsigned int v) {
-  hydIndBrake = v;
-}
-DcsBios::IntegerBuffer hydIndBrakeBuffer(FA_18C_hornet_HYD_IND_BRAKE, onHydIndBrakeChange);
-#pragma endregion Brake Pressure
-
-#pragma region Cabin Pressure
-void onCabinAltIndicatorChange(unsigned int newValue) {
-  cabinAltIndicator = newValue;
-}
-DcsBios::IntegerBuffer cabinAltIndicatorBuffer(FA_18C_hornet_PRESSURE_ALT, onCabinAltIndicatorChange);
-#pragma endregion Cabin Pressure
-
-#pragma region Hydraulics Pressure
-void onHydPressLChange(unsigned int newValue) {
-  hydPressL = newValue;
-}
-DcsBios::IntegerBuffer hydPressLBuffer(FA_18C_hornet_HYD_IND_LEFT, onHydPressLChange);
-
-void onHydPressRChange(unsigned int newValue) {
-  hydPressR = newValue;
-}
-DcsBios::IntegerBuffer hydPressRBuffer(FA_18C_hornet_HYD_IND_RIGHT, onHydPressRChange);
-#pragma endregion Hydraulics Pressure
-
-#pragma region Radar Altimeter
-void onRadaltMinHeightPtrChange(unsigned int newValue) {
-  radarAltimeter.minHeightPtr = newValue;
-}
-DcsBios::IntegerBuffer radaltMinHeightPtrBuffer(FA_18C_hornet_RADALT_MIN_HEIGHT_PTR, onRadaltMinHeightPtrChange);
-
-void onRadaltOffFlagChange(unsigned int newValue) {
-  radarAltimeter.offFlag = newValue;
-}
-DcsBios::IntegerBuffer radaltOffFlagBuffer(FA_18C_hornet_RADALT_OFF_FLAG, onRadaltOffFlagChange);
-
-void onRadaltGreenLampChange(unsigned int newValue) {
-  radarAltimeter.greenLamp = newValue;
-}
-DcsBios::IntegerBuffer radaltGreenLampBuffer(FA_18C_hornet_RADALT_GREEN_LAMP, onRadaltGreenLampChange);
-
-void onLowAltWarnLtChange(unsigned int newValue) {
-  radarAltimeter.warnLt = newValue;
-}
-DcsBios::IntegerBuffer lowAltWarnLtBuffer(FA_18C_hornet_LOW_ALT_WARN_LT, onLowAltWarnLtChange);
-
-void onRadaltAltPtrChange(unsigned int newValue) {
-  radarAltimeter.altPtr = newValue;
-}
-DcsBios::IntegerBuffer radaltAltPtrBuffer(FA_18C_hornet_RADALT_ALT_PTR, onRadaltAltPtrChange);
-#pragma endregion Radar Altimeter
-
-#pragma region IFEI
-//################## RPM  ##################
-void onIfeiRpmLChange(char* newValue) {
-  ifei.rpmL = parse8(newValue);
-}
-DcsBios::StringBuffer<3> ifeiRpmLBuffer(FA_18C_hornet_IFEI_RPM_L_A, onIfeiRpmLChange);
-
-void onIfeiRpmRChange(char* newValue) {
-  ifei.rpmR = parse8(newValue);
-}
-DcsBios::StringBuffer<3> ifeiRpmRBuffer(FA_18C_hornet_IFEI_RPM_R_A, onIfeiRpmRChange);
-
-void onIfeiRpmTextureChange(char* newValue) {
-  ifei.rpmTex = parse8(newValue);
-}
-DcsBios::StringBuffer<1> ifeiRpmTextureBuffer(FA_18C_hornet_IFEI_RPM_TEXTURE_A, onIfeiRpmTextureChange);
-
-// ################## TEMP  ##################
-//Left
-void onIfeiTempLChange(char* newValue) {
-  ifei.tempL = parse16(newValue);
-}
-DcsBios::StringBuffer<3> ifeiTempLBuffer(FA_18C_hornet_IFEI_TEMP_L_A, onIfeiTempLChange);
-
-//Right
-void onIfeiTempRChange(char* newValue) {
-  ifei.tempR = parse16(newValue);
-}
-DcsBios::StringBuffer<3> ifeiTempRBuffer(FA_18C_hornet_IFEI_TEMP_R_A, onIfeiTempRChange);
-
-//Texture
-void onIfeiTempTextureChange(char* newValue) {
-  ifei.tempTex = parse8(newValue);
-}
-DcsBios::StringBuffer<1> ifeiTempTextureBuffer(FA_18C_hornet_IFEI_TEMP_TEXTURE_A, onIfeiTempTextureChange);
-
-//################## SP CODES  ##################
-//SP
-void onIfeiSpChange(char* newValue) {
-  strlcpy(ifei.sp, newValue, sizeof(ifei.sp));
-}
-DcsBios::StringBuffer<3> ifeiSpBuffer(FA_18C_hornet_IFEI_SP_A, onIfeiSpChange);
-
-//Codes
-void onIfeiCodesChange(char* newValue) {
-  strlcpy(ifei.codes, newValue, sizeof(ifei.codes));
-}
-DcsBios::StringBuffer<3> ifeiCodesBuffer(FA_18C_hornet_IFEI_CODES_A, onIfeiCodesChange);
-
-//################## FUEL FLOW  ##################
-//LEFT
-void onIfeiFfLChange(char* newValue) {
-  ifei.ffL = parse8(newValue);
-}
-DcsBios::StringBuffer<3> ifeiFfLBuffer(FA_18C_hornet_IFEI_FF_L_A, onIfeiFfLChange);
-
-//Right
-void onIfeiFfRChange(char* newValue) {
-  ifei.ffR = parse8(newValue);
-}
-DcsBios::StringBuffer<3> ifeiFfRBuffer(FA_18C_hornet_IFEI_FF_R_A, onIfeiFfRChange);
-
-//Texture
-void onIfeiFfTextureChange(char* newValue) {
-  ifei.ffTex = parse8(newValue);
-}
-DcsBios::StringBuffer<1> ifeiFfTextureBuffer(FA_18C_hornet_IFEI_FF_TEXTURE_A, onIfeiFfTextureChange);
-
-//################## OIL  ##################
-//Left
-void onIfeiOilPressLChange(char* newValue) {
-  ifei.oilPressL = parse16(newValue);
-}
-DcsBios::StringBuffer<3> ifeiOilPressLBuffer(FA_18C_hornet_IFEI_OIL_PRESS_L_A, onIfeiOilPressLChange);
-
-//Right
-void onIfeiOilPressRChange(char* newValue) {
-  ifei.oilPressR = parse16(newValue);
-}
-DcsBios::StringBuffer<3> ifeiOilPressRBuffer(FA_18C_hornet_IFEI_OIL_PRESS_R_A, onIfeiOilPressRChange);
-
-//Texture
-void onIfeiOilTextureChange(char* newValue) {
-  ifei.oilTex = parse8(newValue);
-}
-DcsBios::StringBuffer<1> ifeiOilTextureBuffer(FA_18C_hornet_IFEI_OIL_TEXTURE_A, onIfeiOilTextureChange);
-
-//################## NOZZEL Gauges  ##################
-//Left
-//Pointer position
-void onExtNozzlePosLChange(unsigned int newValue) {
-  ifei.extNozzlePosL = newValue;
-}
-DcsBios::IntegerBuffer extNozzlePosLBuffer(FA_18C_hornet_EXT_NOZZLE_POS_L_A, 0xffff, 0, onExtNozzlePosLChange);
-
-//Pointer visibility
-void onIfeiLpointerTextureChange(char* newValue) {
-  ifei.lPointerTex = parse8(newValue);
-}
-DcsBios::StringBuffer<1> ifeiLpointerTextureBuffer(FA_18C_hornet_IFEI_LPOINTER_TEXTURE_A, onIfeiLpointerTextureChange);
-
-//Scale visibility
-void onIfeiLscaleTextureChange(char* newValue) {
-  ifei.lScaleTex = parse8(newValue);
-}
-DcsBios::StringBuffer<1> ifeiLscaleTextureBuffer(FA_18C_hornet_IFEI_LSCALE_TEXTURE_A, onIfeiLscaleTextureChange);
-
-//Scale numbers visibility
-void onIfeiL100TextureChange(char* newValue) {
-  ifei.l100Tex = parse8(newValue);
-}
-DcsBios::StringBuffer<1> ifeiL100TextureBuffer(FA_18C_hornet_IFEI_L100_TEXTURE_A, onIfeiL100TextureChange);
-
-//Right
-//Pointer position
-void onExtNozzlePosRChange(unsigned int newValue) {
-  ifei.extNozzlePosR = newValue;
-}
-DcsBios::IntegerBuffer extNozzlePosRBuffer(FA_18C_hornet_EXT_NOZZLE_POS_R_A, 0xffff, 0, onExtNozzlePosRChange);
-
-//Pointer visibility
-void onIfeiRpointerTextureChange(char* newValue) {
-  ifei.rPointerTex = parse8(newValue);
-}
-DcsBios::StringBuffer<1> ifeiRpointerTextureBuffer(FA_18C_hornet_IFEI_RPOINTER_TEXTURE_A, onIfeiRpointerTextureChange);
-
-//Scale visibility
-void onIfeiRscaleTextureChange(char* newValue) {
-  ifei.rScaleTex = parse8(newValue);
-}
-DcsBios::StringBuffer<1> ifeiRscaleTextureBuffer(FA_18C_hornet_IFEI_RSCALE_TEXTURE_A, onIfeiRscaleTextureChange);
-
-//Scale numbers visibility
-void onIfeiR100TextureChange(char* newValue) {
-  ifei.r100Tex = parse8(newValue);
-}
-DcsBios::StringBuffer<1> ifeiR100TextureBuffer(FA_18C_hornet_IFEI_R100_TEXTURE_A, onIfeiR100TextureChange);
-
-//################## FUEL  ##################
-//Upper
-void onIfeiFuelUpChange(char* newValue) {
-  strlcpy(ifei.fuelUp, newValue, sizeof(ifei.fuelUp));
-}
-DcsBios::StringBuffer<6> ifeiFuelUpBuffer(FA_18C_hornet_IFEI_FUEL_UP_A, onIfeiFuelUpChange);
-
-//Time mode
-void onIfeiTChange(char* newValue) {
-  strlcpy(ifei.t, newValue, sizeof(ifei.t));
-}
-DcsBios::StringBuffer<6> ifeiTBuffer(FA_18C_hornet_IFEI_T_A, onIfeiTChange);
-
-//Tag L
-void onIfeiLTextureChange(char* newValue) {
-  ifei.lTex = parse8(newValue);
-}
-DcsBios::StringBuffer<1> ifeiLTextureBuffer(FA_18C_hornet_IFEI_L_TEXTURE_A, onIfeiLTextureChange);
-
-//Lower
-void onIfeiFuelDownChange(char* newValue) {
-  strlcpy(ifei.fuelDown, newValue, sizeof(ifei.fuelDown));
-}
-DcsBios::StringBuffer<6> ifeiFuelDownBuffer(FA_18C_hornet_IFEI_FUEL_DOWN_A, onIfeiFuelDownChange);
-
-//Time mode
-void onIfeiTimeSetModeChange(char* newValue) {
-  strlcpy(ifei.timeSetMode, newValue, sizeof(ifei.timeSetMode));
-}
-DcsBios::StringBuffer<6> ifeiTimeSetModeBuffer(FA_18C_hornet_IFEI_TIME_SET_MODE_A, onIfeiTimeSetModeChange);
-
-//Tag R
-void onIfeiRTextureChange(char* newValue) {
-  ifei.rTex = parse8(newValue);
-}
-DcsBios::StringBuffer<1> ifeiRTextureBuffer(FA_18C_hornet_IFEI_R_TEXTURE_A, onIfeiRTextureChange);
-
-//################## BINGO ##################
-//Texture
-void onIfeiBingoTextureChange(char* newValue) {
-  ifei.bingoTex = parse8(newValue);
-}
-DcsBios::StringBuffer<1> ifeiBingoTextureBuffer(FA_18C_hornet_IFEI_BINGO_TEXTURE_A, onIfeiBingoTextureChange);
-
-//Digits
-void onIfeiBingoChange(char* newValue) {
-  ifei.bingo = parse16(newValue);
-}
-DcsBios::StringBuffer<5> ifeiBingoBuffer(FA_18C_hornet_IFEI_BINGO_A, onIfeiBingoChange);
-
-//################## CLOCK ##################
-//Upper
-//Hours
-void onIfeiClockHChange(char* newValue) {
-  ifei.clockH = parse8(newValue);
-}
-DcsBios::StringBuffer<2> ifeiClockHBuffer(FA_18C_hornet_IFEI_CLOCK_H_A, onIfeiClockHChange);
-
-//Minutes
-void onIfeiClockMChange(char* newValue) {
-  ifei.clockM = parse8(newValue);
-}
-DcsBios::StringBuffer<2> ifeiClockMBuffer(FA_18C_hornet_IFEI_CLOCK_M_A, onIfeiClockMChange);
+  void publish() {
+    backIndex = shared.exchange(backIndex | freshBit) & indexMask;
+  }
 
-//Seconds
-void onIfeiClockSChange(char* newValue) {
-  ifei.clockS = parse8(newValue);
-}
-DcsBios::StringBuffer<2> ifeiClockSBuffer(FA_18C_hornet_IFEI_CLOCK_S_A, onIfeiClockSChange);
+  bool take() {
+    if (!(shared.load() & freshBit)) {
+      return false;
+    }
+    frontIndex = shared.exchange(frontIndex) & indexMask;
+    return true;
+  }
 
-//Colon 1
-void onIfeiDd1Change(char* newValue) {
-  ifei.dd1 = (uint8_t)newValue[0];
-}
-DcsBios::StringBuffer<1> ifeiDd1Buffer(FA_18C_hornet_IFEI_DD_1_A, onIfeiDd1Change);
+  const T& front() const {
+    return slots[frontIndex];
+  }
 
-//Colon 2
-void onIfeiDd2Change(char* newValue) {
-  ifei.dd2 = (uint8_t)newValue[0];
-}
-DcsBios::StringBuffer<1> ifeiDd2Buffer(FA_18C_hornet_IFEI_DD_2_A, onIfeiDd2Change);
+private:
+  static const uint8_t freshBit = 4;
+  static const uint8_t indexMask = 3;
 
-//Tag Z
-void onIfeiZTextureChange(char* newValue) {
-  ifei.zTex = parse8(newValue);
-}
-DcsBios::StringBuffer<1> ifeiZTextureBuffer(FA_18C_hornet_IFEI_Z_TEXTURE_A, onIfeiZTextureChange);
+  T slots[3]{};
+  uint8_t backIndex = 0;
+  uint8_t frontIndex = 1;
+  std::atomic<uint8_t> shared{ 2 };
+};
 
-//Lower
-//Hours
-void onIfeiTimerHChange(char* newValue) {
-  ifei.timerH = parse8(newValue);
-}
-DcsBios::StringBuffer<2> ifeiTimerHBuffer(FA_18C_hornet_IFEI_TIMER_H_A, onIfeiTimerHChange);
+static SnapshotExchange<CockpitState> exportFrames;
+static volatile uint32_t exportFrameCount = 0;
+static volatile uint32_t exportWordsSeen = 0; // writes in the address range the table listens to
+static volatile uint32_t exportWordsUsed = 0; // those that hit an export field, the rest are skipped
 
-//Minutes
-void onIfeiTimerMChange(char* newValue) {
-  ifei.timerM = parse8(newValue);
-}
-DcsBios::StringBuffer<2> ifeiTimerMBuffer(FA_18C_hornet_IFEI_TIMER_M_A, onIfeiTimerMChange);
+int16_t parse16(const char *s);
+int8_t parse8(const char *s);
 
-//Seconds
-void onIfeiTimerSChange(char* newValue) {
-  ifei.timerS = parse8(newValue);
+void reset() {
+  const MissionType missionType = cockpit.missionType;
+  cockpit = CockpitState{};
+  cockpit.missionType = missionType;
+}
+
+#pragma region Export Table
+// How the value of an export field is turned into its CockpitState member
+enum class Decode : uint8_t {
+  Integer,      // (word & mask) >> shift, into a uint16_t
+  Parse8,       // digits into an int8_t/uint8_t, -1 when blank
+  Parse16,      // digits into an int16_t, -1 when blank
+  Char,         // first character into a uint8_t
+  String,       // copied into a char array
+  AircraftName, // resets the state and sets missionType
+};
+
+struct ExportField {
+  uint16_t address;
+  uint16_t mask;
+  uint8_t shift;
+  Decode decode;
+  uint8_t length; // characters of a string field, 0 for integers
+  uint16_t offset; // destination in CockpitState
+  uint8_t size;
+};
+
+#define COCKPIT_FIELD(field) (uint16_t)offsetof(CockpitState, field), (uint8_t)sizeof(static_cast<CockpitState*>(nullptr)->field)
+// control is an integer define from Addresses.h, it expands to "address, mask, shift"
+#define INTEGER_FIELD(control, field) ExportField{ control, Decode::Integer, 0, COCKPIT_FIELD(field) }
+// address is a string define (the _A suffix) from Addresses.h
+#define STRING_FIELD(address, length, decode, field) ExportField{ address, 0, 0, decode, length, COCKPIT_FIELD(field) }
+// a whole export word at a string define address
+#define WORD_FIELD(address, field) ExportField{ address, 0xffff, 0, Decode::Integer, 0, COCKPIT_FIELD(field) }
+
+// Adding an instrument is one row here plus its member in CockpitState
+static constexpr ExportField exportFields[] = {
+  // DCS Common Data
+  STRING_FIELD(MetadataStart_ACFT_NAME_A, 16, Decode::AircraftName, missionType),
+  INTEGER_FIELD(FA_18C_hornet_COCKKPIT_LIGHT_MODE_SW, ifei.colorMode), // TODO: other common message other than IFEI
+  INTEGER_FIELD(FA_18C_hornet_INSTR_INT_LT, instrumentLighting),
+  INTEGER_FIELD(FA_18C_hornet_CONSOLE_INT_LT, consoleLighting),
+
+  // Airspeed
+  INTEGER_FIELD(FA_18C_hornet_STBY_ASI_AIRSPEED, airspeed),
+
+  // Altimeter
+  INTEGER_FIELD(FA_18C_hornet_STBY_ALT_100_FT_PTR, altimeter.alt100FtPtr),
+  INTEGER_FIELD(FA_18C_hornet_STBY_ALT_1000_FT_CNT, altimeter.alt1000FtCnt),
+  INTEGER_FIELD(FA_18C_hornet_STBY_ALT_10000_FT_CNT, altimeter.alt10000FtCnt),
+  INTEGER_FIELD(FA_18C_hornet_STBY_PRESS_SET_0, altimeter.pressSet0),
+  INTEGER_FIELD(FA_18C_hornet_STBY_PRESS_SET_1, altimeter.pressSet1),
+  INTEGER_FIELD(FA_18C_hornet_STBY_PRESS_SET_2, altimeter.pressSet2),
+
+  // Vertical Velocity Indicator
+  INTEGER_FIELD(FA_18C_hornet_VSI, vsi),
+
+  // Battery Voltage
+  INTEGER_FIELD(FA_18C_hornet_VOLT_U, voltU),
+  INTEGER_FIELD(FA_18C_hornet_VOLT_E, voltE),
+
+  // Brake Pressure
+  INTEGER_FIELD(FA_18C_hornet_HYD_IND_BRAKE, hydIndBrake),
+
+  // Cabin Pressure
+  INTEGER_FIELD(FA_18C_hornet_PRESSURE_ALT, cabinAltIndicator),
+
+  // Hydraulics Pressure
+  INTEGER_FIELD(FA_18C_hornet_HYD_IND_LEFT, hydPressL),
+  INTEGER_FIELD(FA_18C_hornet_HYD_IND_RIGHT, hydPressR),
+
+  // Radar Altimeter
+  INTEGER_FIELD(FA_18C_hornet_RADALT_MIN_HEIGHT_PTR, radarAltimeter.minHeightPtr),
+  INTEGER_FIELD(FA_18C_hornet_RADALT_OFF_FLAG, radarAltimeter.offFlag),
+  INTEGER_FIELD(FA_18C_hornet_RADALT_GREEN_LAMP, radarAltimeter.greenLamp),
+  INTEGER_FIELD(FA_18C_hornet_LOW_ALT_WARN_LT, radarAltimeter.warnLt),
+  INTEGER_FIELD(FA_18C_hornet_RADALT_ALT_PTR, radarAltimeter.altPtr),
+
+  // IFEI
+  //################## RPM  ##################
+  STRING_FIELD(FA_18C_hornet_IFEI_RPM_L_A, 3, Decode::Parse8, ifei.rpmL),
+  STRING_FIELD(FA_18C_hornet_IFEI_RPM_R_A, 3, Decode::Parse8, ifei.rpmR),
+  STRING_FIELD(FA_18C_hornet_IFEI_RPM_TEXTURE_A, 1, Decode::Parse8, ifei.rpmTex),
+  // ################## TEMP  ##################
+  STRING_FIELD(FA_18C_hornet_IFEI_TEMP_L_A, 3, Decode::Parse16, ifei.tempL),
+  STRING_FIELD(FA_18C_hornet_IFEI_TEMP_R_A, 3, Decode::Parse16, ifei.tempR),
+  STRING_FIELD(FA_18C_hornet_IFEI_TEMP_TEXTURE_A, 1, Decode::Parse8, ifei.tempTex),
+  //################## SP CODES  ##################
+  STRING_FIELD(FA_18C_hornet_IFEI_SP_A, 3, Decode::String, ifei.sp),
+  STRING_FIELD(FA_18C_hornet_IFEI_CODES_A, 3, Decode::String, ifei.codes),
+  //################## FUEL FLOW  ##################
+  STRING_FIELD(FA_18C_hornet_IFEI_FF_L_A, 3, Decode::Parse16, ifei.ffL),
+  STRING_FIELD(FA_18C_hornet_IFEI_FF_R_A, 3, Decode::Parse16, ifei.ffR),
+  STRING_FIELD(FA_18C_hornet_IFEI_FF_TEXTURE_A, 1, Decode::Parse8, ifei.ffTex),
+  //################## OIL  ##################
+  STRING_FIELD(FA_18C_hornet_IFEI_OIL_PRESS_L_A, 3, Decode::Parse16, ifei.oilPressL),
+  STRING_FIELD(FA_18C_hornet_IFEI_OIL_PRESS_R_A, 3, Decode::Parse16, ifei.oilPressR),
+  STRING_FIELD(FA_18C_hornet_IFEI_OIL_TEXTURE_A, 1, Decode::Parse8, ifei.oilTex),
+  //################## NOZZEL Gauges  ##################
+  WORD_FIELD(FA_18C_hornet_EXT_NOZZLE_POS_L_A, ifei.extNozzlePosL),
+  STRING_FIELD(FA_18C_hornet_IFEI_LPOINTER_TEXTURE_A, 1, Decode::Parse8, ifei.lPointerTex),
+  STRING_FIELD(FA_18C_hornet_IFEI_LSCALE_TEXTURE_A, 1, Decode::Parse8, ifei.lScaleTex),
+  STRING_FIELD(FA_18C_hornet_IFEI_L100_TEXTURE_A, 1, Decode::Parse8, ifei.l100Tex),
+  WORD_FIELD(FA_18C_hornet_EXT_NOZZLE_POS_R_A, ifei.extNozzlePosR),
+  STRING_FIELD(FA_18C_hornet_IFEI_RPOINTER_TEXTURE_A, 1, Decode::Parse8, ifei.rPointerTex),
+  STRING_FIELD(FA_18C_hornet_IFEI_RSCALE_TEXTURE_A, 1, Decode::Parse8, ifei.rScaleTex),
+  STRING_FIELD(FA_18C_hornet_IFEI_R100_TEXTURE_A, 1, Decode::Parse8, ifei.r100Tex),
+  //################## FUEL  ##################
+  STRING_FIELD(FA_18C_hornet_IFEI_FUEL_UP_A, 6, Decode::String, ifei.fuelUp),
+  STRING_FIELD(FA_18C_hornet_IFEI_T_A, 6, Decode::String, ifei.t),
+  STRING_FIELD(FA_18C_hornet_IFEI_L_TEXTURE_A, 1, Decode::Parse8, ifei.lTex),
+  STRING_FIELD(FA_18C_hornet_IFEI_FUEL_DOWN_A, 6, Decode::String, ifei.fuelDown),
+  STRING_FIELD(FA_18C_hornet_IFEI_TIME_SET_MODE_A, 6, Decode::String, ifei.timeSetMode),
+  STRING_FIELD(FA_18C_hornet_IFEI_R_TEXTURE_A, 1, Decode::Parse8, ifei.rTex),
+  //################## BINGO ##################
+  STRING_FIELD(FA_18C_hornet_IFEI_BINGO_TEXTURE_A, 1, Decode::Parse8, ifei.bingoTex),
+  STRING_FIELD(FA_18C_hornet_IFEI_BINGO_A, 5, Decode::Parse16, ifei.bingo),
+  //################## CLOCK ##################
+  STRING_FIELD(FA_18C_hornet_IFEI_CLOCK_H_A, 2, Decode::Parse8, ifei.clockH),
+  STRING_FIELD(FA_18C_hornet_IFEI_CLOCK_M_A, 2, Decode::Parse8, ifei.clockM),
+  STRING_FIELD(FA_18C_hornet_IFEI_CLOCK_S_A, 2, Decode::Parse8, ifei.clockS),
+  STRING_FIELD(FA_18C_hornet_IFEI_DD_1_A, 1, Decode::Char, ifei.dd1),
+  STRING_FIELD(FA_18C_hornet_IFEI_DD_2_A, 1, Decode::Char, ifei.dd2),
+  STRING_FIELD(FA_18C_hornet_IFEI_Z_TEXTURE_A, 1, Decode::Parse8, ifei.zTex),
+  STRING_FIELD(FA_18C_hornet_IFEI_TIMER_H_A, 2, Decode::Parse8, ifei.timerH),
+  STRING_FIELD(FA_18C_hornet_IFEI_TIMER_M_A, 2, Decode::Parse8, ifei.timerM),
+  STRING_FIELD(FA_18C_hornet_IFEI_TIMER_S_A, 2, Decode::Parse8, ifei.timerS),
+  STRING_FIELD(FA_18C_hornet_IFEI_DD_3_A, 1, Decode::Char, ifei.dd3),
+  STRING_FIELD(FA_18C_hornet_IFEI_DD_4_A, 1, Decode::Char, ifei.dd4),
+  //################## Display Brightness ##################
+  //Only changes in night mode
+  WORD_FIELD(FA_18C_hornet_IFEI_DISP_INT_LT_A, ifei.dispIntLt),
+
+  // SARI
+  INTEGER_FIELD(FA_18C_hornet_SAI_SLIP_BALL, sai.slipBall),
+  INTEGER_FIELD(FA_18C_hornet_SAI_BANK, sai.bank),
+  INTEGER_FIELD(FA_18C_hornet_SAI_RATE_OF_TURN, sai.rateOfTurn),
+  INTEGER_FIELD(FA_18C_hornet_SAI_MAN_PITCH_ADJ, sai.manPitchAdj),
+  INTEGER_FIELD(FA_18C_hornet_SAI_PITCH, sai.pitch),
+  INTEGER_FIELD(FA_18C_hornet_SAI_ATT_WARNING_FLAG, sai.attWarningFlag),
+  INTEGER_FIELD(FA_18C_hornet_SAI_POINTER_HOR, sai.pointerHor),
+  INTEGER_FIELD(FA_18C_hornet_SAI_POINTER_VER, sai.pointerVer),
+};
+
+static constexpr size_t exportFieldCount = sizeof(exportFields) / sizeof(exportFields[0]);
+
+static constexpr bool isValidExportField(const ExportField& f) {
+  switch (f.decode) {
+  case Decode::Integer: return f.size == 2 && f.length == 0;
+  case Decode::Parse8: return f.size == 1 && f.length > 0;
+  case Decode::Parse16: return f.size == 2 && f.length > 0;
+  case Decode::Char: return f.size == 1 && f.length > 0;
+  case Decode::String: return f.size > f.length;
+  case Decode::AircraftName: return f.size == sizeof(MissionType) && f.length > 0;
+  }
+  return false;
 }
-DcsBios::StringBuffer<2> ifeiTimerSBuffer(FA_18C_hornet_IFEI_TIMER_S_A, onIfeiTimerSChange);
 
-//Colon 1
-void onIfeiDd3Change(char* newValue) {
-  ifei.dd3 = (uint8_t)newValue[0];
+static constexpr bool areValidExportFields() {
+  for (size_t i = 0; i < exportFieldCount; i++) {
+    if (!isValidExportField(exportFields[i])) {
+      return false;
+    }
+  }
+  return true;
 }
-DcsBios::StringBuffer<1> ifeiDd3Buffer(FA_18C_hornet_IFEI_DD_3_A, onIfeiDd3Change);
+static_assert(areValidExportFields(), "exportFields: decode kind does not match the destination member");
 
-//Colon 2
-void onIfeiDd4Change(char* newValue) {
-  ifei.dd4 = (uint8_t)newValue[0];
+// Characters of all string fields, each followed by a terminator
+static constexpr size_t exportTextSize() {
+  size_t size = 0;
+  for (size_t i = 0; i < exportFieldCount; i++) {
+    if (exportFields[i].length > 0) {
+      size += exportFields[i].length + 1;
+    }
+  }
+  return size;
 }
-DcsBios::StringBuffer<1> ifeiDd4Buffer(FA_18C_hornet_IFEI_DD_4_A, onIfeiDd4Change);
 
-//################## Display Brightness ##################
-//Only changes in night mode
+// One entry per 16 bit export word a field occupies, sorted by address for the lookup
+static constexpr size_t exportWordCount() {
+  size_t count = 0;
+  for (size_t i = 0; i < exportFieldCount; i++) {
+    const ExportField& f = exportFields[i];
+    count += f.length == 0 ? 1 : ((f.address + f.length - 1) >> 1) - (f.address >> 1) + 1;
+  }
+  return count;
+}
+
+struct ExportWord {
+  uint16_t address;
+  uint8_t field;
+  uint16_t text; // first character of the field in exportText
+};
+static_assert(exportFieldCount <= 255, "ExportWord::field is a uint8_t");
+
+class ExportTable : public DcsBios::ExportStreamListener {
+public:
+  ExportTable() : DcsBios::ExportStreamListener(lowestAddress(), highestAddress()) {
+    size_t count = 0;
+    uint16_t text = 0;
+    for (size_t i = 0; i < exportFieldCount; i++) {
+      const ExportField& f = exportFields[i];
+      if (f.length == 0) {
+        insert(count++, ExportWord{ f.address, (uint8_t)i, 0 });
+        markInterest(f.address);
+        continue;
+      }
+      for (uint16_t address = f.address & ~1u; address < f.address + f.length; address += 2) {
+        insert(count++, ExportWord{ address, (uint8_t)i, text });
+        markInterest(address);
+      }
+      text += f.length + 1;
+    }
+  }
 
-void onIfeiDispIntLtChange(unsigned int newValue) {
-  ifei.dispIntLt = newValue;
-}
-DcsBios::IntegerBuffer ifeiDispIntLtBuffer(FA_18C_hornet_IFEI_DISP_INT_LT_A, 0xffff, 0, onIfeiDispIntLtChange);
-#pragma endregion IFEI
+  void onDcsBiosWrite(unsigned int address, unsigned int value) override {
+    exportWordsSeen = exportWordsSeen + 1;
+    // The export covers thousands of words and a few dozen are of interest, most writes end here
+    if (address > 0xffff || !(interest[address >> 6] & (1u << ((address >> 1) & 31)))) {
+      return;
+    }
+    exportWordsUsed = exportWordsUsed + 1;
+
+    // First entry for this word, several fields may share one
+    size_t lo = 0;
+    size_t hi = exportWordCount();
+    while (lo < hi) {
+      const size_t mid = (lo + hi) / 2;
+      if (words[mid].address < address) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    for (size_t i = lo; i < exportWordCount() && words[i].address == address; i++) {
+      const ExportWord& w = words[i];
+      const ExportField& f = exportFields[w.field];
+      if (f.length == 0) {
+        const uint16_t v = (value & f.mask) >> f.shift;
+        memcpy(reinterpret_cast<uint8_t*>(&cockpit) + f.offset, &v, sizeof(v));
+      } else {
+        setChar(w, f, address, value & 0xff);
+        setChar(w, f, address + 1, value >> 8);
+      }
+    }
+  }
 
-#pragma region SARI
-void onSaiSlipBallChange(unsigned int v) {
-  sai.slipBall = v;
-}
-DcsBios::IntegerBuffer saiSlipBallBuffer(FA_18C_hornet_SAI_SLIP_BALL, onSaiSlipBallChange);
+  // Strings are only decoded once the whole export frame is in, like DcsBios::StringBuffer
+  void onConsistentData() override {
+    uint16_t text = 0;
+    for (size_t i = 0; i < exportFieldCount; i++) {
+      const ExportField& f = exportFields[i];
+      if (f.length == 0) {
+        continue;
+      }
+      if (dirty[i]) {
+        dirty[i] = false;
+        decode(f, this->text + text);
+      }
+      text += f.length + 1;
+    }
+    exportFrames.back() = cockpit;
+    exportFrames.publish();
+    exportFrameCount = exportFrameCount + 1;
+  }
 
-void onSaiBankChange(unsigned int v) {
-  sai.bank = v;
-}
-DcsBios::IntegerBuffer saiBankBuffer(FA_18C_hornet_SAI_BANK, onSaiBankChange);
+private:
+  static constexpr unsigned int lowestAddress() {
+    unsigned int address = 0xffff;
+    for (size_t i = 0; i < exportFieldCount; i++) {
+      address = exportFields[i].address < address ? exportFields[i].address & ~1u : address;
+    }
+    return address;
+  }
 
-void onSaiRateOfTurnChange(unsigned int v) {
-  sai.rateOfTurn = v;
-}
-DcsBios::IntegerBuffer saiRateOfTurnBuffer(FA_18C_hornet_SAI_RATE_OF_TURN, onSaiRateOfTurnChange);
+  static constexpr unsigned int highestAddress() {
+    unsigned int address = 0;
+    for (size_t i = 0; i < exportFieldCount; i++) {
+      const ExportField& f = exportFields[i];
+      const unsigned int last = f.length == 0 ? f.address : f.address + f.length - 1;
+      address = last > address ? last : address;
+    }
+    return address;
+  }
 
-void onSaiManPitchAdjChange(unsigned int v) {
-  sai.manPitchAdj = v;
-}
-DcsBios::IntegerBuffer saiManPitchAdjBuffer(FA_18C_hornet_SAI_MAN_PITCH_ADJ, onSaiManPitchAdjChange);
+  void markInterest(unsigned int address) {
+    interest[address >> 6] |= 1u << ((address >> 1) & 31);
+  }
 
-void onSaiPitchChange(unsigned int v) {
-  sai.pitch = v;
-}
-DcsBios::IntegerBuffer saiPitchBuffer(FA_18C_hornet_SAI_PITCH, onSaiPitchChange);
+  // Insertion sort, only runs once at boot
+  void insert(size_t count, const ExportWord& word) {
+    size_t j = count;
+    while (j > 0 && words[j - 1].address > word.address) {
+      words[j] = words[j - 1];
+      j--;
+    }
+    words[j] = word;
+  }
 
-void onSaiAttWarningFlagChange(unsigned int v) {
-  sai.attWarningFlag = v;
-}
-DcsBios::IntegerBuffer saiAttWarningFlagBuffer(FA_18C_hornet_SAI_ATT_WARNING_FLAG, onSaiAttWarningFlagChange);
+  void setChar(const ExportWord& w, const ExportField& f, unsigned int address, char c) {
+    if (address < f.address || address >= (unsigned int)(f.address + f.length)) {
+      return;
+    }
+    char& slot = text[w.text + address - f.address];
+    if (slot != c) {
+      slot = c;
+      dirty[w.field] = true;
+    }
+  }
 
-void onSaiPointerHorChange(unsigned int v) {
-  sai.pointerHor = v;
-}
-DcsBios::IntegerBuffer saiPointerHorBuffer(FA_18C_hornet_SAI_POINTER_HOR, onSaiPointerHorChange);
+  static void decode(const ExportField& f, const char* s) {
+    uint8_t* dst = reinterpret_cast<uint8_t*>(&cockpit) + f.offset;
+    switch (f.decode) {
+    case Decode::Parse8: {
+      const int8_t v = parse8(s);
+      memcpy(dst, &v, sizeof(v));
+      break;
+    }
+    case Decode::Parse16: {
+      const int16_t v = parse16(s);
+      memcpy(dst, &v, sizeof(v));
+      break;
+    }
+    case Decode::Char:
+      *dst = (uint8_t)s[0];
+      break;
+    case Decode::String:
+      strlcpy(reinterpret_cast<char*>(dst), s, f.size);
+      break;
+    case Decode::AircraftName:
+      reset();
+      cockpit.missionType = strcmp(s, "FA-18C_hornet") == 0 ? MissionType::Hornet : MissionType::Other;
+      break;
+    default:
+      break;
+    }
+  }
 
-void onSaiPointerVerChange(unsigned int v) {
-  sai.pointerVer = v;
-}
-DcsBios::IntegerBuffer saiPointerVerBuffer(FA_18C_hornet_SAI_POINTER_VER, onSaiPointerVerChange);
+  ExportWord words[exportWordCount()];
+  uint32_t interest[0x10000 / 64] = {}; // one bit per 16 bit export word
+  char text[exportTextSize()] = {};
+  bool dirty[exportFieldCount] = {};
+};
 
-#pragma endregion SARI
+static ExportTable exportTable;
+#pragma endregion Export Table
 
 #pragma region Helpers
 int16_t parse16(const char *s) {
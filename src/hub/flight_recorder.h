@@ -0,0 +1,184 @@
+#pragma once
+
+#include <Arduino.h>
+#include <cstdint>
+#include "frame_log.h"
+
+// Flight recorder, built with -DHUB_FLIGHT_RECORDER: every frame the hub sends is kept on
+// LittleFS as a frame log (include/frame_log.h) that frame_injector plays back on the host.
+// sendFrameTo() only copies the frame into a RAM ring; a low priority task on core 0 appends
+// it to flash, so erase and write stalls never reach loop(). The log is two segment files
+// used in turn: when the current one is full the older one is truncated and continued in, so
+// the most recent one to two segments of the sortie are kept. A boot starts a new recording.
+//
+// Console: 'r' pauses or resumes recording, 'x' writes the recording to the console as one
+// frame log (raw bytes, oldest frame first) and resumes.
+
+#if defined(HUB_FLIGHT_RECORDER) && defined(ARDUINO_ARCH_ESP32)
+
+#include <LittleFS.h>
+#include <atomic>
+
+#ifndef HUB_RECORDER_SEGMENT_BYTES
+  #define HUB_RECORDER_SEGMENT_BYTES (1536 * 1024) // two of them fit the default 16 MB layout
+#endif
+
+static const size_t recorderBufferSize = 16384; // power of two, about 4 s of traffic
+static const uint32_t recorderFlushInterval = 1000; // ms, bounds what a power loss takes
+static const char* const recorderSegments[2] = { "/frames0.hfl", "/frames1.hfl" };
+
+class FlightRecorder {
+public:
+  void begin() {
+    if (!LittleFS.begin(true)) {
+      return;
+    }
+    LittleFS.remove(recorderSegments[1]);
+    openSegment(0);
+    xTaskCreatePinnedToCore(task, "recorder", 4096, this, 1, nullptr, 0);
+  }
+
+  // From loop(), never blocks; a frame that does not fit the ring is counted and dropped
+  void record(uint32_t ms, const uint8_t* data, size_t len) {
+    const size_t h = head.load(std::memory_order_relaxed);
+    const size_t used = h - tail.load(std::memory_order_acquire);
+    const FrameLogRecord r{ ms, (uint8_t)len };
+    if (recordingPaused || used + sizeof(r) + len > recorderBufferSize) {
+      dropped++;
+      return;
+    }
+    put(h, reinterpret_cast<const uint8_t*>(&r), sizeof(r));
+    put(h + sizeof(r), data, len);
+    head.store(h + sizeof(r) + len, std::memory_order_release);
+  }
+
+  void handleCommand(char c, Stream& console) {
+    if (c == 'r') {
+      recordingPaused = !recordingPaused;
+      console.printf("recorder %s, %u frames dropped\n", recordingPaused ? "paused" : "recording", (unsigned)dropped);
+    } else if (c == 'x') {
+      dump(console);
+    }
+  }
+
+private:
+  void put(size_t at, const uint8_t* p, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+      buffer[(at + i) & (recorderBufferSize - 1)] = p[i];
+    }
+  }
+
+  void get(size_t at, uint8_t* p, size_t len) const {
+    for (size_t i = 0; i < len; i++) {
+      p[i] = buffer[(at + i) & (recorderBufferSize - 1)];
+    }
+  }
+
+  void openSegment(uint8_t s) {
+    segment = s;
+    file = LittleFS.open(recorderSegments[segment], "w");
+    file.write(reinterpret_cast<const uint8_t*>(FRAME_LOG_MAGIC), FRAME_LOG_MAGIC_SIZE);
+    segmentBytes = FRAME_LOG_MAGIC_SIZE;
+  }
+
+  static void task(void* arg) {
+    static_cast<FlightRecorder*>(arg)->run();
+  }
+
+  // Whole records only, so each segment stays a valid frame log on its own
+  void run() {
+    uint32_t flushedAt = millis();
+    for (;;) {
+      if (dumpRequested) {
+        file.close();
+        dumpReady = true;
+        while (dumpRequested) {
+          vTaskDelay(pdMS_TO_TICKS(10));
+        }
+        dumpReady = false;
+        file = LittleFS.open(recorderSegments[segment], "a");
+      }
+
+      size_t t = tail.load(std::memory_order_relaxed);
+      const size_t h = head.load(std::memory_order_acquire);
+      if (h == t) {
+        flushIfDue(flushedAt);
+        vTaskDelay(pdMS_TO_TICKS(10));
+        continue;
+      }
+      while (t != h) {
+        FrameLogRecord r;
+        get(t, reinterpret_cast<uint8_t*>(&r), sizeof(r));
+        const size_t recordLen = sizeof(r) + r.len;
+        if (segmentBytes + recordLen > HUB_RECORDER_SEGMENT_BYTES) {
+          file.close();
+          openSegment(segment ^ 1);
+        }
+        uint8_t chunk[sizeof(FrameLogRecord) + 255];
+        get(t, chunk, recordLen);
+        file.write(chunk, recordLen);
+        segmentBytes += recordLen;
+        t += recordLen;
+      }
+      tail.store(t, std::memory_order_release);
+      // Under steady traffic the ring is seldom empty, the flush cannot wait for that
+      flushIfDue(flushedAt);
+    }
+  }
+
+  void flushIfDue(uint32_t& flushedAt) {
+    if (millis() - flushedAt >= recorderFlushInterval) {
+      file.flush();
+      flushedAt = millis();
+    }
+  }
+
+  // Blocks loop() while it runs; frames sent meanwhile are dropped from the recording
+  void dump(Stream& console) {
+    dumpRequested = true;
+    while (!dumpReady) {
+      delay(1);
+    }
+    console.write(reinterpret_cast<const uint8_t*>(FRAME_LOG_MAGIC), FRAME_LOG_MAGIC_SIZE);
+    for (uint8_t i = 1; i <= 2; i++) {
+      File f = LittleFS.open(recorderSegments[(segment + i) & 1], "r");
+      if (!f) {
+        continue;
+      }
+      f.seek(FRAME_LOG_MAGIC_SIZE);
+      uint8_t chunk[512];
+      size_t n;
+      while ((n = f.read(chunk, sizeof(chunk))) > 0) {
+        console.write(chunk, n);
+      }
+      f.close();
+    }
+    dumpRequested = false;
+  }
+
+  uint8_t buffer[recorderBufferSize];
+  std::atomic<size_t> head{ 0 }; // advanced by loop()
+  std::atomic<size_t> tail{ 0 }; // advanced by the recorder task
+  volatile uint32_t dropped = 0;
+  volatile bool recordingPaused = false;
+  volatile bool dumpRequested = false;
+  volatile bool dumpReady = false;
+  File file;
+  uint8_t segment = 0;
+  size_t segmentBytes = 0;
+};
+
+#else
+
+// Without HUB_FLIGHT_RECORDER nothing is recorded (hub_replay has --frames instead)
+class FlightRecorder {
+public:
+  void begin() {}
+  void record(uint32_t ms, const uint8_t* data, size_t len) {}
+  template<typename S>
+  void handleCommand(char c, S& console) {}
+};
+
+#endif
+
+static FlightRecorder flightRecorder;
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <Arduino.h>
+#include <cstdint>
+#include "message.h"
+#include "scheduler.h"
+
+// The hub's own counters, closed every telemetryInterval into a TelemetryMessage that is
+// broadcast and kept for the console (include/telemetry.h)
+static const uint32_t telemetryInterval = 1000; // ms
+
+// Running totals kept elsewhere, sampled at the end of each interval
+struct HubTotals {
+  uint32_t sendFailures;
+  uint32_t superseded;
+  uint32_t exportFrames;
+  uint32_t dcsBiosBytes;
+  uint32_t exportWordsSeen;
+  uint32_t exportWordsUsed;
+  uint32_t rxErrors;
+};
+
+class HubStats {
+public:
+  // Every frame the transport accepted
+  void recordFrame(const uint8_t* data, size_t len) {
+    current.framesSent++;
+    current.airtimeBytes += len + frameOverheadBytes;
+    count(data);
+    // The records of superframes and unicast frames to subscribed gauges are counted too
+    if (isRecordContainer(reinterpret_cast<const MessageHeader*>(data)->category)) {
+      forEachMessage(data, (int)len, [this](const uint8_t* record, int recordLen) {
+        count(record);
+      });
+    }
+  }
+
+  void recordLoop(uint32_t us) {
+    current.loopMicros += us;
+    current.loops++;
+    if (us > current.loopMaxUs) {
+      current.loopMaxUs = us;
+    }
+  }
+
+  // True when an interval ended, `m` then holds it
+  bool service(uint32_t now, const HubTotals& totals, TelemetryMessage& m) {
+    if (now - intervalStartedAt < telemetryInterval) {
+      return false;
+    }
+    const Interval& c = current;
+    m.framesSent = clamp16(c.framesSent);
+    m.airtimeBytes = clamp16(c.airtimeBytes);
+    m.sendFailures = clamp16(totals.sendFailures - previous.sendFailures);
+    m.superseded = clamp16(totals.superseded - previous.superseded);
+    m.exportFrames = clamp16(totals.exportFrames - previous.exportFrames);
+    m.dcsBiosBytes = totals.dcsBiosBytes - previous.dcsBiosBytes;
+    // Payload only, sync and address/length framing is parsed whatever the bitmap says
+    const uint32_t seen = totals.exportWordsSeen - previous.exportWordsSeen;
+    const uint32_t used = totals.exportWordsUsed - previous.exportWordsUsed;
+    m.dcsBiosSkipped = seen > used ? (uint16_t)((uint64_t)(seen - used) * 1000 / seen) : 0;
+    m.rxErrors = clamp16(totals.rxErrors - previous.rxErrors);
+    m.loopMeanUs = clamp16(c.loops ? (uint32_t)(c.loopMicros / c.loops) : 0);
+    m.loopMaxUs = clamp16(c.loopMaxUs);
+    for (size_t i = 0; i < messageCategoryCount; i++) {
+      m.records[i] = clamp16(c.records[i]);
+    }
+    for (size_t i = 0; i < sizeof(m.backoff); i++) {
+      m.backoff[i] = priorityStretch[static_cast<size_t>(Priority::High) + i];
+    }
+    m.header.ms = now;
+    last = m;
+    current = Interval{};
+    previous = totals;
+    intervalStartedAt = now;
+    return true;
+  }
+
+  // The last complete interval
+  const TelemetryMessage& latest() const {
+    return last;
+  }
+
+private:
+  void count(const uint8_t* message) {
+    const size_t category = static_cast<size_t>(reinterpret_cast<const MessageHeader*>(message)->category);
+    if (category < messageCategoryCount) {
+      current.records[category]++;
+    }
+  }
+
+  static uint16_t clamp16(uint32_t v) {
+    return v > 0xFFFF ? 0xFFFF : (uint16_t)v;
+  }
+
+  struct Interval {
+    uint32_t framesSent;
+    uint32_t airtimeBytes;
+    uint32_t records[messageCategoryCount];
+    uint64_t loopMicros;
+    uint32_t loops;
+    uint32_t loopMaxUs;
+  };
+
+  Interval current{};
+  uint32_t intervalStartedAt = 0;
+  HubTotals previous{};
+  TelemetryMessage last{};
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <Arduino.h>
+#include <cstdint>
+#include "dcsbios_handler.h"
+
+// On the board the DCS-BIOS serial stream is read and parsed by its own task pinned to core 0,
+// while loop() diffs and transmits on core 1, so a slow send or a large copy never leaves bytes
+// waiting in the UART. Complete export frames reach loop() through exportFrames. Host builds
+// (hub_replay) have no FreeRTOS and parse inline from loop().
+#if defined(ARDUINO_ARCH_ESP32)
+  #define HUB_INGEST_TASK 1
+#else
+  #define HUB_INGEST_TASK 0
+#endif
+
+// DCS-BIOS arrives on Serial either way. The hub environment leaves it on the UART, capped at
+// 250000 baud. hub_usb (-DHUB_INGEST_USB) builds with TinyUSB and CDC on boot, which makes
+// Serial the S3's native USB port: the PC writes at USB full speed whatever baud rate the
+// COM port is opened with, so an export burst on mission load drains in milliseconds instead
+// of queueing behind the UART.
+#if defined(HUB_INGEST_USB)
+static const size_t ingestRxBufferSize = 16384; // USB CDC receive queue, whole mission load bursts
+#else
+static const size_t ingestRxBufferSize = 4096; // UART driver ring buffer, ~160 ms at 250000 baud
+#endif
+static const size_t ingestChunkSize = 256;
+
+// Bytes parsed, and receive errors reported by the UART or USB driver
+struct IngestStats {
+  volatile uint32_t bytesParsed;
+  volatile uint32_t fifoOverflows; // hardware FIFO overran before the driver emptied it
+  volatile uint32_t bufferFull;    // driver receive buffer full, the parser fell behind
+  volatile uint32_t otherErrors;   // break, framing, parity
+};
+
+static IngestStats ingestStats{};
+
+// The bytes are handed to the parser here instead of by DcsBios::loop(), which then finds
+// nothing left to read, so they can be counted
+static void pumpDcsBios() {
+  uint8_t chunk[ingestChunkSize];
+  uint32_t parsed = 0;
+  size_t n;
+  while ((n = Serial.read(chunk, sizeof(chunk))) > 0) {
+    for (size_t i = 0; i < n; i++) {
+      DcsBios::parser.processChar(chunk[i]);
+    }
+    parsed += n;
+  }
+  ingestStats.bytesParsed = ingestStats.bytesParsed + parsed;
+  DcsBios::loop();
+}
+
+#if HUB_INGEST_TASK
+
+static const uint32_t ingestTaskStack = 4096;
+static const UBaseType_t ingestTaskPriority = 2; // above loop(), below the WiFi stack
+static const BaseType_t ingestTaskCore = 0;
+
+static void ingestTask(void*) {
+  for (;;) {
+    pumpDcsBios();
+    vTaskDelay(1);
+  }
+}
+
+static void startIngest() {
+  Serial.setRxBufferSize(ingestRxBufferSize);
+#if defined(HUB_INGEST_USB)
+  Serial.onEvent(ARDUINO_USB_CDC_RX_OVERFLOW_EVENT, [](void*, esp_event_base_t, int32_t, void*) {
+    ingestStats.bufferFull = ingestStats.bufferFull + 1;
+  });
+#else
+  Serial.onReceiveError([](hardwareSerial_error_t error) {
+    switch (error) {
+    case UART_FIFO_OVF_ERROR: ingestStats.fifoOverflows = ingestStats.fifoOverflows + 1; break;
+    case UART_BUFFER_FULL_ERROR: ingestStats.bufferFull = ingestStats.bufferFull + 1; break;
+    default: ingestStats.otherErrors = ingestStats.otherErrors + 1; break;
+    }
+  });
+#endif
+  DcsBios::setup();
+  xTaskCreatePinnedToCore(ingestTask, "dcsbios", ingestTaskStack, nullptr, ingestTaskPriority, nullptr, ingestTaskCore);
+}
+
+static void serviceIngest() {
+}
+
+#else
+
+static void startIngest() {
+  DcsBios::setup();
+}
+
+static void serviceIngest() {
+  pumpDcsBios();
+}
+
+#endif
@@ -1,54 +1,191 @@
 #include <Arduino.h>
-#include <WiFi.h>
-#include <esp_wifi.h>
-#include <esp_now.h>
 #include <cstdint>
 
 #include "message.h"
+#include "transport.h"
+#include "ifei_codec.h"
+#include "attitude_codec.h"
+#include "altimeter_codec.h"
 #include "dcsbios_handler.h"
+#include "ingest.h"
+#include "scheduler.h"
+#include "rate_control.h"
+#include "peers.h"
+#include "trends.h"
+#include "tx_queue.h"
+#include "fec.h"
+#include "hub_stats.h"
+#include "telemetry.h"
+#include "flight_recorder.h"
 
-static void addPeer(const uint8_t mac[6]) {
-  esp_now_peer_info_t peer{};
-  memcpy(peer.peer_addr, mac, 6);
-  peer.channel = 0;
-  peer.encrypt = false;
-  esp_err_t err = esp_now_add_peer(&peer);
-  //Serial.printf("esp_now_add_peer: %s\n", esp_err_to_name(err));
-}
+// The console takes whichever port DCS-BIOS does not: the native USB port when DCS-BIOS has the
+// UART, the UART (the board's USB-to-UART bridge) when DCS-BIOS has native USB
+#if defined(ARDUINO_ARCH_ESP32) && defined(HUB_INGEST_USB)
+  #define HubConsole Serial0
+#elif defined(ARDUINO_ARCH_ESP32) && ARDUINO_USB_MODE && !ARDUINO_USB_CDC_ON_BOOT
+  #define HubConsole HWCDCSerial
+#endif
 
-// static uint8_t DISPLAY_MAC[6] = { 0x28, 0x37, 0x2F, 0x84, 0x66, 0xC8 }; // IFEI display
-static uint8_t BROADCAST_MAC[6] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF }; // Broadcast address
+static HubStats hubStats;
+static RateController rateControl;
+static uint32_t sendsRefused = 0; // by the driver, e.g. ESP_ERR_ESPNOW_NO_MEM
 
-static void initEspNow() {
+static void initTransport() {
   delay(1000);
-  WiFi.mode(WIFI_STA);
-  esp_wifi_set_channel(ESP_CHANNEL, WIFI_SECOND_CHAN_NONE);
-  esp_wifi_set_max_tx_power(ESP_MAX_TX_POWER);
-  esp_err_t err = esp_now_init();
-  //Serial.printf("esp_now_init: %s\n", esp_err_to_name(err));
-
+  Transport::begin();
   delay(100);
-  addPeer(BROADCAST_MAC);
+  Transport::onReceive(onPeerMessage);
+  Transport::onSent(onSendCompleted);
+}
+
+static bool sendFrameTo(const uint8_t* mac, const uint8_t* data, size_t len) {
+  sendsQueued = sendsQueued + 1;
+  if (!Transport::send(mac, data, len)) {
+    sendsQueued = sendsQueued - 1; // no send callback follows
+    sendsRefused++;
+    return false;
+  }
+  chargeAirtime(len);
+  hubStats.recordFrame(data, len);
+  flightRecorder.record(millis(), data, len);
+  return true;
+}
+
+static bool sendFrame(const uint8_t* data, size_t len) {
+  return sendFrameTo(Transport::broadcastMac, data, len);
+}
+
+// Broadcast records wait in txQueue until the driver has room for them. Frames are handed over
+// while fewer than txMaxInFlight have not come back through the send callback; one the driver
+// refuses (ESP_ERR_ESPNOW_NO_MEM) is built again on the next pass from whatever is queued then.
+static const uint32_t txMaxInFlight = 2;
+static const uint32_t txStallTimeout = 50; // ms without a send callback before sending anyway
+
+static TxQueue txQueue;
+static uint32_t txSentAt = 0;
+
+static uint8_t nextSeq[messageCategoryCount];
+
+// Sequence numbers are only used up by frames that went out, so gauges count no false losses
+static void stampHeader(MessageHeader& header) {
+  header.seq = nextSeq[static_cast<size_t>(header.category)]++;
+  header.schema = messageSchema;
+}
+
+static ParityEncoder parityEncoder;
+
+// Parity completed by the frames of one flush is held and queued at the start of the next one,
+// behind the records already waiting there. It rides in a later tick's frame, so a burst loss
+// seldom takes out a group and its parity, and it costs a record rather than a frame of its own.
+static ParityMessage heldParity[fecProtectedCount];
+static size_t heldParityLen[fecProtectedCount]; // 0 when nothing is held
+
+static void holdParity(const ParityMessage& parity, size_t len) {
+  const int index = fecIndex(parity.protects);
+  heldParity[index] = parity;
+  heldParityLen[index] = len;
+}
+
+static void holdParities(const SuperframeMessage& frame, uint8_t records, uint32_t now) {
+  const uint8_t* record = reinterpret_cast<const uint8_t*>(&frame) + sizeof(MessageHeader);
+  for (uint8_t i = 0; i < records; i++, record += 2 + record[1]) {
+    ParityMessage parity;
+    size_t len;
+    if (parityEncoder.add(record + 2, record[1], now, parity, len)) {
+      holdParity(parity, len);
+    }
+  }
+}
+
+static void queueHeldParities(uint32_t now) {
+  ParityMessage parity;
+  size_t len;
+  while (parityEncoder.expire(now, parity, len)) {
+    holdParity(parity, len);
+  }
+  if (txQueue.empty()) {
+    return; // nothing to ride with yet
+  }
+  for (size_t i = 0; i < fecProtectedCount; i++) {
+    if (heldParityLen[i]) {
+      txQueue.put(&heldParity[i], heldParityLen[i]);
+      heldParityLen[i] = 0;
+    }
+  }
+}
+
+static void flushMessages() {
+  const uint32_t now = millis();
+  queueHeldParities(now);
+  while (!txQueue.empty()) {
+    if (sendsQueued - sendsCompleted >= txMaxInFlight && now - txSentAt < txStallTimeout) {
+      return;
+    }
+    SuperframeMessage frame{};
+    size_t used = sizeof(MessageHeader);
+    const uint8_t records = txQueue.take(frame, used);
+    if (records == 0) {
+      return;
+    }
+
+    uint8_t seqBefore[messageCategoryCount];
+    memcpy(seqBefore, nextSeq, sizeof(nextSeq));
+    uint8_t* record = reinterpret_cast<uint8_t*>(&frame) + sizeof(MessageHeader);
+    for (uint8_t i = 0; i < records; i++, record += 2 + record[1]) {
+      stampHeader(*reinterpret_cast<MessageHeader*>(record + 2));
+    }
+
+    bool sent;
+    if (records == 1) {
+      // A lone message goes out bare, the superframe wrapper would only add overhead
+      record = reinterpret_cast<uint8_t*>(&frame) + sizeof(MessageHeader);
+      sent = sendFrame(record + 2, record[1]);
+    } else {
+      stampHeader(frame.header);
+      frame.header.ms = now;
+      sent = sendFrame(reinterpret_cast<const uint8_t*>(&frame), used);
+    }
+    if (!sent) {
+      memcpy(nextSeq, seqBefore, sizeof(nextSeq));
+      return;
+    }
+    txQueue.commit();
+    txSentAt = now;
+    holdParities(frame, records, now);
+  }
 }
 
 template<typename T>
-static void sendMessage(const T& m) {
-  const uint8_t *dest = BROADCAST_MAC;
-  esp_err_t e = esp_now_send(dest, reinterpret_cast<const uint8_t *>(&m), sizeof(m));
-  //Serial.printf("esp_now_send %s\n", esp_err_to_name(e));
+static void queueMessage(const T& m, size_t len = sizeof(T)) {
+  txQueue.put(&m, len);
 }
 
-static void sendIntegerMessage(ValueName name, uint16_t value) {
+static void queueIntegerMessage(ValueName name, uint16_t value) {
   IntegerMessage m{};
   m.header.ms = millis();
   m.name = name;
   m.value = value;
-  sendMessage(m);
+  queueMessage(m);
+}
+
+// Subscribed gauges get reliable values by unicast. Broadcast still serves gauges that never
+// announced themselves, and carries the rolling keyframes.
+static void queueValue(ValueName name, uint16_t value, bool keyframe) {
+  if (!keyframe) {
+    publishReliable(name, value);
+  }
+  if (keyframe || !hasReliableSubscriber(name)) {
+    queueIntegerMessage(name, value);
+  }
 }
 
 void setup() {
-  DcsBios::setup();
-  initEspNow();
+#ifdef HubConsole
+  HubConsole.begin(115200);
+#endif
+  flightRecorder.begin();
+  startIngest();
+  initTransport();
   delay(300);
 }
 
@@ -68,110 +205,276 @@ static uint16_t previousHydPressR;
 static uint16_t previousInstrumentLighting;
 static uint16_t previousConsoleLighting;
 
-static const uint32_t messageInterval = 33; // 1000 / messageInterval Hz max
-static const uint32_t ifeiMessageInterval = 100;
-static const uint32_t periodicMessageInterval = 5000;
-static uint32_t lastSendAt = 0;
-static uint32_t lastIfeiSendAt = 0;
-static uint32_t lastPeriodicSendAt = 0; // To resend values that seldom change and might be missed (e.g. hyd pressure, battery, hyd indicator brake)
+// State the channels are diffed against, taken from the last complete export frame
+static CockpitState frame{};
+static const uint32_t exportFrameMinInterval = 0; // ms, diff at most this often, 0 diffs every export frame
+static uint32_t lastExportFrameAt = 0;
 
-void loop() {
-  DcsBios::loop();
+static void takeExportFrame(uint32_t now) {
+  if (now - lastExportFrameAt < exportFrameMinInterval || !exportFrames.take()) {
+    return;
+  }
+  frame = exportFrames.front();
+  lastExportFrameAt = now;
+  updateTrends(frame, now);
+}
 
-  const uint32_t now = millis();
+static const uint32_t ifeiKeyframeInterval = 1000; // Full IFEI frame at least this often so a lost delta heals
+static uint32_t lastIfeiKeyframeAt = 0;
+static IfeiMessage ifeiQueuedBase{}; // what gauges have while an IFEI record waits in txQueue
 
-  if (missionType != previousMissionType) {
-    // Any cleanup?
+// After the values of this tick, so a gauge has the value before it applies its rate. Rates still
+// waiting in txQueue go again in the record that replaces them.
+static void queueTrends() {
+  if (const uint8_t* queued = txQueue.queued(MessageCategory::Trend)) {
+    trendsDue |= queued[offsetof(TrendMessage, fields)];
   }
-
-  // Limit IFEI refresh rate due to its data size and update frequency
-  if (now - lastIfeiSendAt > ifeiMessageInterval && !isEqualIfeiMessage(ifei, previousIfei)) {
-    previousIfei = ifei;
-    previousIfei.header.ms = millis();
-    sendMessage(previousIfei);
-    lastIfeiSendAt = now;
+  TrendMessage m{};
+  const size_t len = takeTrends(m);
+  if (len > 0) {
+    m.header.ms = millis();
+    queueMessage(m, len);
   }
+}
 
-  bool periodicSend = previousMissionType == MissionType::Hornet && now - lastPeriodicSendAt > periodicMessageInterval;
-  periodicSend = false; // Disable for now, need to check if this is really necessary
-  if (periodicSend) {
-    lastPeriodicSendAt = now;
+static void queueTelemetry(uint32_t now) {
+  const HubTotals totals{
+    sendsRefused + sendsFailed,
+    txQueue.superseded,
+    exportFrameCount,
+    ingestStats.bytesParsed,
+    exportWordsSeen,
+    exportWordsUsed,
+    ingestStats.fifoOverflows + ingestStats.bufferFull,
+  };
+  TelemetryMessage m{};
+  if (hubStats.service(now, totals, m)) {
+    queueMessage(m);
   }
+}
 
-  if (now - lastSendAt > messageInterval) {
-    if (missionType != previousMissionType) {
-      previousMissionType = missionType;
-      sendIntegerMessage(ValueName::MissionChanged, static_cast<uint8_t>(missionType));
+// Sending 's' to the console prints the last telemetry interval, see flight_recorder.h for 'r' and 'x'
+static void serviceConsole() {
+#ifdef HubConsole
+  while (HubConsole.available() > 0) {
+    const char c = HubConsole.read();
+    if (c == 's') {
+      printTelemetry(HubConsole, hubStats.latest());
+    } else {
+      flightRecorder.handleCommand(c, HubConsole);
     }
+  }
+#endif
+}
 
-    if (instrumentLighting != previousInstrumentLighting) {
-      previousInstrumentLighting = instrumentLighting;
-      sendIntegerMessage(ValueName::InstrumentLighting, instrumentLighting);
-    }
+static Change visibleIf(bool changed) {
+  return changed ? Change::Visible : Change::None;
+}
 
-    if (consoleLighting != previousConsoleLighting) {
-      previousConsoleLighting = consoleLighting;
-      sendIntegerMessage(ValueName::ConsoleLighting, consoleLighting);
-    }
+// Any Kollsman change shows, the altitude has the channel's deadband
+static Change altimeterChange(uint16_t deadband) {
+  AltimeterMessage now;
+  encodeAltimeter(frame.altimeter, now);
+  const Change change = changeOf(previousAltimeter.altitude, now.altitude, deadband);
+  return larger(change, visibleIf(now.kollsman != previousAltimeter.kollsman));
+}
 
-    if (!isEqualAltimeterMessage(altimeter, previousAltimeter)) {
-      previousAltimeter = altimeter;
-      previousAltimeter.header.ms = millis();
-      sendMessage(previousAltimeter);
-    }
+static Change changeOf(Channel channel) {
+  const uint16_t deadband = channelPolicies[static_cast<size_t>(channel)].deadband;
+  switch (channel) {
+  case Channel::MissionChanged: return visibleIf(frame.missionType != previousMissionType);
+  case Channel::InstrumentLighting: return changeOf(previousInstrumentLighting, frame.instrumentLighting, deadband);
+  case Channel::ConsoleLighting: return changeOf(previousConsoleLighting, frame.consoleLighting, deadband);
+  case Channel::Sai: return visibleIf(!isEqualMessage(frame.sai, previousSai));
+  case Channel::Altimeter: return altimeterChange(deadband);
+  case Channel::RadarAltimeter: return visibleIf(!isEqualMessage(frame.radarAltimeter, previousRadarAltimeter));
+  case Channel::Airspeed: return changeOf(previousAirspeed, frame.airspeed, deadband);
+  case Channel::VerticalVelocityIndicator: return changeOf(previousVsi, frame.vsi, deadband);
+  case Channel::Ifei: return visibleIf(!isEqualMessage(frame.ifei, previousIfei));
+  case Channel::VoltU: return changeOf(previousVoltU, frame.voltU, deadband);
+  case Channel::VoltE: return changeOf(previousVoltE, frame.voltE, deadband);
+  case Channel::BrakePressure: return changeOf(previousHydIndBrake, frame.hydIndBrake, deadband);
+  case Channel::CabinAltitudeIndicator: return changeOf(previousCabinAltIndicator, frame.cabinAltIndicator, deadband);
+  case Channel::HydraulicPressureLeft: return changeOf(previousHydPressL, frame.hydPressL, deadband);
+  case Channel::HydraulicPressureRight: return changeOf(previousHydPressR, frame.hydPressR, deadband);
+  default: return Change::None;
+  }
+}
 
-    if (!isEqualRadarAltimeterMessage(radarAltimeter, previousRadarAltimeter)) {
-      previousRadarAltimeter = radarAltimeter;
-      previousRadarAltimeter.header.ms = millis();
-      sendMessage(previousRadarAltimeter);
-    }
+static bool isUrgent(Channel channel) {
+  switch (channel) {
+  case Channel::Sai: return frame.sai.attWarningFlag != previousSai.attWarningFlag;
+  case Channel::RadarAltimeter: return frame.radarAltimeter.warnLt != previousRadarAltimeter.warnLt;
+  default: return false;
+  }
+}
 
-    if (!isEqualSaiMessage(sai, previousSai)) {
-      previousSai = sai;
-      previousSai.header.ms = millis();
-      sendMessage(previousSai);
-    }
+static void sendIfei(bool keyframe) {
+  const uint32_t now = millis();
+  // A record still queued is replaced by one that also carries its changes
+  const uint8_t* queued = txQueue.queued(MessageCategory::IFEI);
+  if (!queued) {
+    ifeiQueuedBase = previousIfei;
+  } else if (reinterpret_cast<const MessageHeader*>(queued)->category != MessageCategory::IFEIDelta) {
+    keyframe = true;
+  }
+  IfeiDeltaMessage delta{};
+  const size_t deltaLen = makeIfeiDelta(ifeiQueuedBase, frame.ifei, delta);
+  previousIfei = frame.ifei;
+  // Deltas name their base by the low bits of its ms, the next state must not share them
+  previousIfei.header.ms = (uint16_t)now == (uint16_t)ifeiQueuedBase.header.ms ? now + 1 : now;
 
-    if (airspeed != previousAirspeed) {
-      previousAirspeed = airspeed;
-      sendIntegerMessage(ValueName::Airspeed, airspeed);
-    }
+  // Keyframes use the compact layout unless a field does not fit it
+  IfeiCompactMessage compact{};
+  const bool isCompact = encodeIfeiCompact(previousIfei, compact);
+  const size_t keyframeLen = isCompact ? sizeof(IfeiCompactMessage) : sizeof(IfeiMessage);
 
-    if (vsi != previousVsi) {
-      previousVsi = vsi;
-      sendIntegerMessage(ValueName::VerticalVelocityIndicator, vsi);
+  // Most updates only carry the changed fields (e.g. clock seconds)
+  if (keyframe || now - lastIfeiKeyframeAt > ifeiKeyframeInterval || deltaLen >= keyframeLen) {
+    if (isCompact) {
+      queueMessage(compact);
+    } else {
+      queueMessage(previousIfei);
     }
+    lastIfeiKeyframeAt = now;
+  } else {
+    delta.header.ms = previousIfei.header.ms;
+    queueMessage(delta, deltaLen);
+  }
+}
 
-    if (voltU != previousVoltU || periodicSend) {
-      previousVoltU = voltU;
-      sendIntegerMessage(ValueName::VoltU, voltU);
-    }
+// Attitude changes go out as a few bytes against the last full SaiMessage, which is resent at
+// least every saiResyncInterval so a gauge that lost it is back within that time
+static const uint32_t saiResyncInterval = 250;
+static SaiMessage saiBase{};
 
-    if (voltE != previousVoltE || periodicSend) {
-      previousVoltE = voltE;
-      sendIntegerMessage(ValueName::VoltE, voltE);
-    }
+// previousSai holds what the gauge decoded, not the exact attitude, so the rounding left behind
+// still reads as a change. Steps below the quantization wait for more motion; once the attitude
+// stood still for saiSettleTime the full message puts the gauge on the exact value.
+static const uint32_t saiSettleTime = 100; // ms, about three export frames
+static SaiMessage saiTarget{};
+static uint32_t saiTargetSince = 0;
 
-    if (hydIndBrake != previousHydIndBrake || periodicSend) {
-      previousHydIndBrake = hydIndBrake;
-      sendIntegerMessage(ValueName::BrakePressure, hydIndBrake);
+static void sendSai(bool keyframe) {
+  const uint32_t now = millis();
+  SaiMessage target = frame.sai;
+  target.header.ms = now;
+  if (!isEqualMessage(target, saiTarget)) {
+    saiTarget = target;
+    saiTargetSince = now;
+  }
+  const bool settled = now - saiTargetSince >= saiSettleTime;
+  AttitudeMessage attitude{};
+  attitude.header.ms = now;
+  SaiMessage decoded;
+  if (!keyframe && !settled && now - saiBase.header.ms < saiResyncInterval &&
+      encodeAttitude(saiBase, target, attitude) && decodeAttitude(attitude, saiBase, decoded)) {
+    if (!isEqualMessage(decoded, previousSai)) {
+      previousSai = decoded;
+      queueMessage(attitude);
     }
+    return;
+  }
+  // Deltas are told apart by the low bits of the base's ms, two bases never share them
+  if ((uint16_t)now == attitudeBase(saiBase)) {
+    target.header.ms = now + 1;
+  }
+  saiBase = target;
+  previousSai = target;
+  queueMessage(saiBase);
+}
 
-    if (cabinAltIndicator != previousCabinAltIndicator || periodicSend) {
-      previousCabinAltIndicator = cabinAltIndicator;
-      sendIntegerMessage(ValueName::CabinAltitudeIndicator, cabinAltIndicator);
-    }
+static void sendChannel(Channel channel, bool keyframe) {
+  switch (channel) {
+  case Channel::MissionChanged:
+    previousMissionType = frame.missionType;
+    queueValue(ValueName::MissionChanged, static_cast<uint8_t>(frame.missionType), keyframe);
+    break;
+  case Channel::InstrumentLighting:
+    previousInstrumentLighting = frame.instrumentLighting;
+    queueValue(ValueName::InstrumentLighting, frame.instrumentLighting, keyframe);
+    break;
+  case Channel::ConsoleLighting:
+    previousConsoleLighting = frame.consoleLighting;
+    queueValue(ValueName::ConsoleLighting, frame.consoleLighting, keyframe);
+    break;
+  case Channel::Sai:
+    sendSai(keyframe);
+    markTrendDue(TrendField::SaiBank, keyframe);
+    markTrendDue(TrendField::SaiPitch, keyframe);
+    markTrendDue(TrendField::SaiSlipBall, keyframe);
+    markTrendDue(TrendField::SaiRateOfTurn, keyframe);
+    break;
+  case Channel::Altimeter:
+    encodeAltimeter(frame.altimeter, previousAltimeter);
+    previousAltimeter.header.ms = millis();
+    queueMessage(previousAltimeter);
+    markTrendDue(TrendField::Altitude, keyframe);
+    break;
+  case Channel::RadarAltimeter:
+    previousRadarAltimeter = frame.radarAltimeter;
+    previousRadarAltimeter.header.ms = millis();
+    queueMessage(previousRadarAltimeter);
+    break;
+  case Channel::Airspeed:
+    previousAirspeed = frame.airspeed;
+    queueValue(ValueName::Airspeed, frame.airspeed, keyframe);
+    markTrendDue(TrendField::Airspeed, keyframe);
+    break;
+  case Channel::VerticalVelocityIndicator:
+    previousVsi = frame.vsi;
+    queueValue(ValueName::VerticalVelocityIndicator, frame.vsi, keyframe);
+    markTrendDue(TrendField::VerticalVelocityIndicator, keyframe);
+    break;
+  case Channel::Ifei:
+    sendIfei(keyframe);
+    break;
+  case Channel::VoltU:
+    previousVoltU = frame.voltU;
+    queueValue(ValueName::VoltU, frame.voltU, keyframe);
+    break;
+  case Channel::VoltE:
+    previousVoltE = frame.voltE;
+    queueValue(ValueName::VoltE, frame.voltE, keyframe);
+    break;
+  case Channel::BrakePressure:
+    previousHydIndBrake = frame.hydIndBrake;
+    queueValue(ValueName::BrakePressure, frame.hydIndBrake, keyframe);
+    break;
+  case Channel::CabinAltitudeIndicator:
+    previousCabinAltIndicator = frame.cabinAltIndicator;
+    queueValue(ValueName::CabinAltitudeIndicator, frame.cabinAltIndicator, keyframe);
+    break;
+  case Channel::HydraulicPressureLeft:
+    previousHydPressL = frame.hydPressL;
+    queueValue(ValueName::HydraulicPressureLeft, frame.hydPressL, keyframe);
+    break;
+  case Channel::HydraulicPressureRight:
+    previousHydPressR = frame.hydPressR;
+    queueValue(ValueName::HydraulicPressureRight, frame.hydPressR, keyframe);
+    break;
+  default:
+    break;
+  }
+}
 
-    if (hydPressL != previousHydPressL || periodicSend) {
-      previousHydPressL = hydPressL;
-      sendIntegerMessage(ValueName::HydraulicPressureLeft, hydPressL);
-    }
+void loop() {
+  const uint32_t loopStartedAt = micros();
+  serviceIngest();
 
-    if (hydPressR != previousHydPressR || periodicSend) {
-      previousHydPressR = hydPressR;
-      sendIntegerMessage(ValueName::HydraulicPressureRight, hydPressR);
-    }
+  // A new frame is diffed right away, channels held back by their rate or the budget go out later
+  const uint32_t now = millis();
+  takeExportFrame(now);
+  rateControl.service(now, SendTotals{ sendsCompleted, sendsFailed, sendsRefused, airtimeBytesSent });
+  runScheduler(now);
+  queueTrends();
+  queueTelemetry(now);
+  flushMessages();
 
-    lastSendAt = now;
-  }
+  Transport::poll();
+  updatePeers(now);
+  answerClockPings(now);
+  serviceUnicast(now);
+  serviceConsole();
+  hubStats.recordLoop(micros() - loopStartedAt);
 }
@@ -0,0 +1,304 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <cstdint>
+#include "message.h"
+#include "transport.h"
+#include "subscription.h"
+
+// Gauges that announced themselves (SubscribeMessage). Rarely changing values a gauge
+// subscribed to are delivered to it as acknowledged unicast and retried until the MAC layer
+// confirms them; broadcast is never acknowledged, so a lost one stayed lost until the value
+// changed again. High rate streams stay broadcast.
+static const uint16_t reliableValues =
+  valueBit(ValueName::VoltU) | valueBit(ValueName::VoltE) |
+  valueBit(ValueName::BrakePressure) | valueBit(ValueName::CabinAltitudeIndicator) |
+  valueBit(ValueName::HydraulicPressureLeft) | valueBit(ValueName::HydraulicPressureRight) |
+  valueBit(ValueName::InstrumentLighting) | valueBit(ValueName::ConsoleLighting) |
+  valueBit(ValueName::MissionChanged);
+
+static const size_t maxPeers = 16;                 // ESP-NOW allows 20 unencrypted peers
+static const uint32_t peerTimeout = 3 * subscriptionInterval;
+static const uint32_t unicastRetryInterval = 20;   // ms after a failed attempt
+static const uint32_t unicastAckTimeout = 100;     // ms without a send callback counts as failed
+static const uint8_t unicastMaxAttempts = 8;       // then broadcast until the gauge's next announcement
+
+// Implemented by the hub: charge the airtime and hand a frame to the transport
+static bool sendFrameTo(const uint8_t* mac, const uint8_t* data, size_t len);
+// Implemented by the hub: queue a value for the next broadcast frame
+static void queueIntegerMessage(ValueName name, uint16_t value);
+
+struct Peer {
+  bool active;
+  uint8_t mac[6];
+  uint32_t categories;
+  uint16_t values;
+  uint16_t pendingValues; // subscribed values not yet confirmed delivered
+  uint32_t lastSeenAt;
+  uint32_t retryAt;
+  uint8_t attempts;
+  uint8_t nextSeq;
+};
+
+static Peer peers[maxPeers];
+static uint16_t latestValues[valueNameCount];
+
+// Announcements arrive in the WiFi task and are applied from loop()
+struct Announcement {
+  uint8_t mac[6];
+  SubscribeMessage message;
+};
+
+static portMUX_TYPE announcementMux = portMUX_INITIALIZER_UNLOCKED;
+static Announcement announcements[4];
+static size_t announcementCount = 0;
+
+// Clock pings are timestamped on arrival and answered from loop(), see latency_stats.h
+struct ClockPing {
+  uint8_t mac[6];
+  uint8_t seq;
+  int64_t gaugeSentUs;
+  int64_t receivedUs;
+};
+
+static ClockPing clockPings[4];
+static size_t clockPingCount = 0;
+
+// Send callbacks come back in send order, counting them finds the one of our unicast
+static volatile uint32_t sendsQueued = 0;
+static volatile uint32_t sendsCompleted = 0;
+static volatile uint32_t sendsFailed = 0; // completed without acknowledgement
+static volatile uint32_t unicastTicket = 0;
+static volatile bool unicastCompleted = false;
+static volatile bool unicastDelivered = false;
+static int unicastPeer = -1;
+static uint16_t unicastValues = 0;
+static uint32_t unicastSentAt = 0;
+
+static void onClockPing(const uint8_t* mac, const ClockPingMessage& ping) {
+  const int64_t receivedUs = esp_timer_get_time();
+  portENTER_CRITICAL_ISR(&announcementMux);
+  if (clockPingCount < sizeof(clockPings) / sizeof(clockPings[0])) {
+    ClockPing& p = clockPings[clockPingCount++];
+    memcpy(p.mac, mac, sizeof(p.mac));
+    p.seq = ping.header.seq;
+    p.gaugeSentUs = ping.gaugeSentUs;
+    p.receivedUs = receivedUs;
+  }
+  portEXIT_CRITICAL_ISR(&announcementMux);
+}
+
+static void onPeerMessage(const uint8_t* mac, const uint8_t* data, int len) {
+  if (len < (int)sizeof(MessageHeader) || reinterpret_cast<const MessageHeader*>(data)->schema != messageSchema) {
+    return;
+  }
+  if (len == (int)sizeof(ClockPingMessage) &&
+      reinterpret_cast<const MessageHeader*>(data)->category == MessageCategory::ClockPing) {
+    onClockPing(mac, *reinterpret_cast<const ClockPingMessage*>(data));
+    return;
+  }
+  if (len != (int)sizeof(SubscribeMessage) ||
+      reinterpret_cast<const MessageHeader*>(data)->category != MessageCategory::Subscribe) {
+    return;
+  }
+  portENTER_CRITICAL_ISR(&announcementMux);
+  if (announcementCount < sizeof(announcements) / sizeof(announcements[0])) {
+    Announcement& a = announcements[announcementCount++];
+    memcpy(a.mac, mac, sizeof(a.mac));
+    memcpy(&a.message, data, sizeof(a.message));
+  }
+  portEXIT_CRITICAL_ISR(&announcementMux);
+}
+
+static void onSendCompleted(bool delivered) {
+  const uint32_t completed = sendsCompleted + 1;
+  sendsCompleted = completed;
+  if (!delivered) {
+    sendsFailed = sendsFailed + 1;
+  }
+  if (completed == unicastTicket) {
+    unicastDelivered = delivered;
+    unicastCompleted = true;
+  }
+}
+
+static Peer* findPeer(const uint8_t mac[6]) {
+  Peer* slot = nullptr;
+  for (Peer& p : peers) {
+    if (p.active && memcmp(p.mac, mac, 6) == 0) {
+      return &p;
+    }
+    if (!p.active && !slot) {
+      slot = &p;
+    }
+  }
+  if (slot) {
+    *slot = Peer{};
+    memcpy(slot->mac, mac, 6);
+    if (!Transport::addPeer(mac)) {
+      return nullptr;
+    }
+    slot->active = true;
+  }
+  return slot;
+}
+
+// Each announcement is answered with everything reliable it subscribed to, so a gauge that
+// just booted has those values right away
+static void updatePeers(uint32_t now) {
+  Announcement pending[sizeof(announcements) / sizeof(announcements[0])];
+  portENTER_CRITICAL(&announcementMux);
+  const size_t count = announcementCount;
+  memcpy(pending, announcements, count * sizeof(Announcement));
+  announcementCount = 0;
+  portEXIT_CRITICAL(&announcementMux);
+
+  for (size_t i = 0; i < count; i++) {
+    Peer* peer = findPeer(pending[i].mac);
+    if (!peer) {
+      continue;
+    }
+    peer->categories = pending[i].message.categories;
+    peer->values = pending[i].message.values;
+    peer->pendingValues |= peer->values & reliableValues;
+    peer->attempts = 0;
+    peer->lastSeenAt = now;
+  }
+
+  for (size_t i = 0; i < maxPeers; i++) {
+    Peer& p = peers[i];
+    if (p.active && now - p.lastSeenAt > peerTimeout && unicastPeer != (int)i) {
+      p.active = false;
+      Transport::removePeer(p.mac);
+    }
+  }
+}
+
+// The pong echoes the ping's seq so the gauge's LinkStats counts lost exchanges
+static void answerClockPings(uint32_t now) {
+  ClockPing pending[sizeof(clockPings) / sizeof(clockPings[0])];
+  portENTER_CRITICAL(&announcementMux);
+  const size_t count = clockPingCount;
+  memcpy(pending, clockPings, count * sizeof(ClockPing));
+  clockPingCount = 0;
+  portEXIT_CRITICAL(&announcementMux);
+
+  for (size_t i = 0; i < count; i++) {
+    Peer* peer = findPeer(pending[i].mac);
+    if (!peer) {
+      continue;
+    }
+    peer->lastSeenAt = now;
+
+    ClockPongMessage pong{};
+    pong.header.seq = pending[i].seq;
+    pong.header.ms = now;
+    pong.header.schema = messageSchema;
+    pong.gaugeSentUs = pending[i].gaugeSentUs;
+    pong.hubReceivedUs = pending[i].receivedUs;
+    pong.hubSentUs = esp_timer_get_time();
+    sendFrameTo(peer->mac, reinterpret_cast<const uint8_t*>(&pong), sizeof(pong));
+  }
+}
+
+static bool hasReliableSubscriber(ValueName name) {
+  const uint16_t bit = valueBit(name);
+  if (!(reliableValues & bit)) {
+    return false;
+  }
+  for (const Peer& p : peers) {
+    if (p.active && (p.values & bit)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void publishReliable(ValueName name, uint16_t value) {
+  latestValues[static_cast<size_t>(name)] = value;
+  if (!(reliableValues & valueBit(name))) {
+    return;
+  }
+  for (Peer& p : peers) {
+    if (p.active && (p.values & valueBit(name))) {
+      p.pendingValues |= valueBit(name);
+      p.attempts = 0;
+    }
+  }
+}
+
+static void finishUnicast(uint32_t now, bool delivered) {
+  Peer& p = peers[unicastPeer];
+  if (delivered) {
+    p.attempts = 0;
+  } else {
+    // Values published meanwhile are already pending again, the rest goes back too
+    p.pendingValues |= unicastValues;
+    p.retryAt = now + unicastRetryInterval;
+    if (++p.attempts >= unicastMaxAttempts) {
+      // The gauge falls back to broadcast until it announces again, starting with what did not
+      // get through; hasReliableSubscriber() no longer counts it
+      for (size_t v = 0; v < valueNameCount; v++) {
+        if (p.pendingValues & (1u << v)) {
+          queueIntegerMessage(static_cast<ValueName>(v), latestValues[v]);
+        }
+      }
+      p.values &= ~reliableValues;
+      p.pendingValues = 0;
+      p.attempts = 0;
+    }
+  }
+  unicastPeer = -1;
+}
+
+// One unicast in flight at a time, peers take turns
+static void serviceUnicast(uint32_t now) {
+  if (unicastPeer >= 0) {
+    if (unicastCompleted) {
+      finishUnicast(now, unicastDelivered);
+    } else if (now - unicastSentAt > unicastAckTimeout) {
+      finishUnicast(now, false);
+    } else {
+      return;
+    }
+  }
+
+  static size_t nextPeer = 0;
+  for (size_t n = 0; n < maxPeers; n++) {
+    const size_t i = (nextPeer + n) % maxPeers;
+    Peer& p = peers[i];
+    if (!p.active || !p.pendingValues || (int32_t)(now - p.retryAt) < 0) {
+      continue;
+    }
+
+    UnicastMessage frame{};
+    frame.header.category = MessageCategory::Unicast;
+    frame.header.seq = p.nextSeq++;
+    frame.header.ms = now;
+    frame.header.schema = messageSchema;
+    size_t used = sizeof(MessageHeader);
+    for (size_t v = 0; v < valueNameCount; v++) {
+      if (p.pendingValues & (1u << v)) {
+        IntegerMessage m{};
+        m.header.ms = now;
+        m.header.schema = messageSchema;
+        m.name = static_cast<ValueName>(v);
+        m.value = latestValues[v];
+        appendSuperframeRecord(frame, used, &m, sizeof(m));
+      }
+    }
+
+    unicastPeer = (int)i;
+    unicastValues = p.pendingValues;
+    unicastSentAt = now;
+    unicastCompleted = false;
+    unicastTicket = sendsQueued + 1;
+    p.pendingValues = 0;
+    if (!sendFrameTo(p.mac, reinterpret_cast<const uint8_t*>(&frame), used)) {
+      finishUnicast(now, false);
+    }
+    nextPeer = i + 1;
+    return;
+  }
+}
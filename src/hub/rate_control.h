@@ -0,0 +1,73 @@
+#pragma once
+
+#include <Arduino.h>
+#include <cstdint>
+#include "scheduler.h"
+
+// Backs the scheduler off when the channel is congested, lowest priority first, and brings it
+// back when the channel clears. Every rateControlWindow the send outcomes and the airtime used
+// are compared against the thresholds below: a congested window doubles minInterval of the
+// lowest priority that is not backed off as far as it may be (Low, then Normal, then High), a clear
+// one takes an eighth of the nominal interval off the highest priority that is backed off. The
+// SAI is Critical and never slowed down, the battery and pressure gauges are the first to give.
+static const uint32_t rateControlWindow = 250; // ms
+// How far each priority may be slowed down, High keeps the altimeter and airspeed usable
+static const uint8_t maxStretch[priorityCount] = { nominalStretch, 4 * nominalStretch, 8 * nominalStretch, 8 * nominalStretch };
+static const uint32_t congestedFailurePercent = 10; // of the sends in a window, refused or not completed
+static const uint32_t congestedFailureMin = 2;      // a single failure is noise
+static const uint32_t congestedAirtimePercent = 90; // of airtimeBudgetBytesPerSecond
+
+// Running totals kept elsewhere, sampled at the end of each window
+struct SendTotals {
+  uint32_t completed;
+  uint32_t failed;  // completed without success
+  uint32_t refused; // by the driver, its queue was full
+  uint32_t airtimeBytes;
+};
+
+class RateController {
+public:
+  void service(uint32_t now, const SendTotals& totals) {
+    if (now - windowStartedAt < rateControlWindow) {
+      return;
+    }
+    const uint32_t elapsed = now - windowStartedAt;
+    const uint32_t failures = (totals.failed - previous.failed) + (totals.refused - previous.refused);
+    const uint32_t attempts = (totals.completed - previous.completed) + (totals.refused - previous.refused);
+    const uint32_t airtime = totals.airtimeBytes - previous.airtimeBytes;
+    const bool congested =
+      (failures >= congestedFailureMin && failures * 100 >= attempts * congestedFailurePercent) ||
+      (uint64_t)airtime * 1000 * 100 >= (uint64_t)airtimeBudgetBytesPerSecond * elapsed * congestedAirtimePercent;
+    if (congested) {
+      backOff();
+    } else {
+      rampUp();
+    }
+    previous = totals;
+    windowStartedAt = now;
+  }
+
+private:
+  // Multiplicative decrease of the rate
+  static void backOff() {
+    for (size_t p = priorityCount - 1; p > 0; p--) {
+      if (priorityStretch[p] < maxStretch[p]) {
+        priorityStretch[p] = min(priorityStretch[p] * 2, (int)maxStretch[p]);
+        return;
+      }
+    }
+  }
+
+  // Additive increase, the most important priority is restored first
+  static void rampUp() {
+    for (size_t p = 1; p < priorityCount; p++) {
+      if (priorityStretch[p] > nominalStretch) {
+        priorityStretch[p]--;
+        return;
+      }
+    }
+  }
+
+  uint32_t windowStartedAt = 0;
+  SendTotals previous{};
+};
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <Arduino.h>
+#include <cstdint>
+
+// Everything the hub can broadcast, one entry per independently scheduled value
+enum class Channel : uint8_t {
+  MissionChanged,
+  InstrumentLighting,
+  ConsoleLighting,
+  Sai,
+  Altimeter,
+  RadarAltimeter,
+  Airspeed,
+  VerticalVelocityIndicator,
+  Ifei,
+  VoltU,
+  VoltE,
+  BrakePressure,
+  CabinAltitudeIndicator,
+  HydraulicPressureLeft,
+  HydraulicPressureRight,
+  Count, // Keep last
+};
+
+static constexpr size_t channelCount = static_cast<size_t>(Channel::Count);
+
+enum class Priority : uint8_t {
+  Critical, // never held back by the airtime budget
+  High,
+  Normal,
+  Low,
+  Count, // Keep last
+};
+
+static constexpr size_t priorityCount = static_cast<size_t>(Priority::Count);
+
+struct ChannelPolicy {
+  Priority priority;
+  uint16_t minInterval; // ms between two sends, caps the rate; stretched under congestion
+  uint16_t deadline;    // ms a change may wait before it is overdue
+  uint8_t size;         // typical bytes on air, checked against the airtime budget
+  uint16_t deadband;    // raw units per display step on the gauge (its map()), 0 sends every change
+};
+
+static const ChannelPolicy channelPolicies[channelCount] = {
+  { Priority::Critical, 0,   0,   10, 0    }, // MissionChanged
+  { Priority::Normal,   100, 200, 10, 0    }, // InstrumentLighting
+  { Priority::Normal,   100, 200, 10, 0    }, // ConsoleLighting
+  { Priority::Critical, 10,  10,  16, 0    }, // Sai, mostly AttitudeMessage, every export frame (~30 Hz)
+  { Priority::High,     33,  33,  14, 4    }, // Altimeter, altitude for a tenth of a degree of the needle
+  { Priority::High,     33,  50,  18, 0    }, // RadarAltimeter
+  { Priority::High,     33,  50,  10, 18   }, // Airspeed, 3500 tenths of a degree
+  { Priority::High,     33,  50,  10, 18   }, // VerticalVelocityIndicator, 3600 tenths of a degree
+  { Priority::Normal,   33,  66,  40, 0    }, // Ifei
+  { Priority::Low,      100, 500, 10, 546  }, // VoltU, 120 degrees
+  { Priority::Low,      100, 500, 10, 546  }, // VoltE, 120 degrees
+  { Priority::Low,      100, 500, 10, 1310 }, // BrakePressure, 50 degrees
+  { Priority::Low,      100, 500, 10, 22   }, // CabinAltitudeIndicator, 2960 tenths of a degree
+  { Priority::Low,      100, 500, 10, 204  }, // HydraulicPressureLeft, 320 degrees
+  { Priority::Low,      100, 500, 10, 204  }, // HydraulicPressureRight, 320 degrees
+};
+
+// How far a value moved since it was last sent. A move below the deadband shows on no gauge and
+// is held back until it has stood for deadbandFlushDelay, so jitter costs nothing and the final
+// value still arrives once it settles.
+enum class Change : uint8_t {
+  None,
+  Small,
+  Visible,
+};
+
+static const uint16_t deadbandFlushDelay = 250; // ms
+
+static Change changeOf(int32_t sent, int32_t value, uint16_t deadband) {
+  const int32_t moved = sent > value ? sent - value : value - sent;
+  if (moved == 0) {
+    return Change::None;
+  }
+  return moved >= deadband ? Change::Visible : Change::Small;
+}
+
+static Change larger(Change a, Change b) {
+  return a > b ? a : b;
+}
+
+// Airtime budget as a token bucket of bytes on air, frame overhead included
+static const uint32_t airtimeBudgetBytesPerSecond = 12000;
+static const int32_t airtimeBurstBytes = 1500;
+static const uint8_t frameOverheadBytes = 40; // MAC header, ESP-NOW vendor element, FCS
+
+// Rolling keyframes: every slot one channel is resent in full even when unchanged, so a gauge
+// that (re)joins mid-mission has every value after at most keyframeWindow. A slot preferably
+// rides along with change driven records in the same superframe, and only goes out alone once
+// it is keyframeSlotLimit late. They only use the budget left above keyframeReserveBytes.
+static const uint16_t keyframeSlotInterval = 50;  // ms
+static const uint16_t keyframeSlotLimit = 100;    // ms
+static const uint32_t keyframeWindow = channelCount * keyframeSlotLimit;
+static const int32_t keyframeReserveBytes = airtimeBurstBytes / 2;
+
+// Implemented by the hub: compare against / update the last sent state of a channel
+static Change changeOf(Channel channel);
+static bool isUrgent(Channel channel);
+static void sendChannel(Channel channel, bool keyframe);
+
+struct ChannelState {
+  bool pending;
+  bool small;           // changed by less than the deadband since smallSince
+  uint32_t pendingSince;
+  uint32_t smallSince;
+  uint32_t lastSentAt;
+};
+
+// minInterval of each priority in eighths, raised by the rate controller (rate_control.h)
+// while the channel is congested; Critical stays at 8
+static const uint8_t nominalStretch = 8;
+static uint8_t priorityStretch[priorityCount] = { nominalStretch, nominalStretch, nominalStretch, nominalStretch };
+
+static ChannelState channelStates[channelCount];
+static int32_t airtimeTokens = airtimeBurstBytes;
+static uint32_t airtimeRefilledAt = 0;
+static uint32_t airtimeBytesSent = 0; // since boot, frame overhead included
+static size_t keyframeCursor = 0;
+static uint32_t lastKeyframeSlotAt = 0;
+
+static void chargeAirtime(size_t frameLen) {
+  airtimeTokens -= (int32_t)(frameLen + frameOverheadBytes);
+  airtimeBytesSent += frameLen + frameOverheadBytes;
+}
+
+static uint32_t minIntervalOf(size_t channel) {
+  const ChannelPolicy& policy = channelPolicies[channel];
+  return (uint32_t)policy.minInterval * priorityStretch[static_cast<size_t>(policy.priority)] / nominalStretch;
+}
+
+static void refillAirtime(uint32_t now) {
+  const uint32_t elapsed = now - airtimeRefilledAt;
+  const int32_t refill = (int32_t)(elapsed * airtimeBudgetBytesPerSecond / 1000);
+  if (refill > 0) {
+    airtimeTokens = min(airtimeTokens + refill, airtimeBurstBytes);
+    airtimeRefilledAt = now;
+  }
+}
+
+static void markSent(Channel channel, uint32_t now) {
+  ChannelState& state = channelStates[static_cast<size_t>(channel)];
+  state.pending = false;
+  state.small = false;
+  state.lastSentAt = now;
+}
+
+// Earliest deadline first, higher priority breaks ties
+static bool sendsBefore(Channel a, Channel b) {
+  const ChannelState& sa = channelStates[static_cast<size_t>(a)];
+  const ChannelState& sb = channelStates[static_cast<size_t>(b)];
+  const ChannelPolicy& pa = channelPolicies[static_cast<size_t>(a)];
+  const ChannelPolicy& pb = channelPolicies[static_cast<size_t>(b)];
+  const int32_t dueA = (int32_t)(sa.pendingSince + pa.deadline);
+  const int32_t dueB = (int32_t)(sb.pendingSince + pb.deadline);
+  if (dueA != dueB) {
+    return dueA - dueB < 0;
+  }
+  return pa.priority < pb.priority;
+}
+
+// Decide what to send in this loop iteration and hand it to sendChannel()
+static void runScheduler(uint32_t now) {
+  refillAirtime(now);
+
+  Channel ready[channelCount];
+  size_t readyCount = 0;
+
+  for (size_t i = 0; i < channelCount; i++) {
+    const Channel channel = static_cast<Channel>(i);
+    ChannelState& state = channelStates[i];
+
+    if (!state.pending) {
+      const Change change = changeOf(channel);
+      if (change == Change::Small && !state.small) {
+        state.small = true;
+        state.smallSince = now;
+      } else if (change == Change::None) {
+        state.small = false;
+      }
+      if (change == Change::Visible || (change == Change::Small && now - state.smallSince >= deadbandFlushDelay)) {
+        state.pending = true;
+        state.pendingSince = now;
+      }
+    }
+    if (!state.pending) {
+      continue;
+    }
+
+    // Warning flag transitions take the fast path: no rate limit, no budget
+    if (isUrgent(channel)) {
+      sendChannel(channel, false);
+      markSent(channel, now);
+      continue;
+    }
+
+    if (now - state.lastSentAt < minIntervalOf(i)) {
+      continue;
+    }
+
+    // Insertion sort, the list is tiny
+    size_t j = readyCount++;
+    while (j > 0 && sendsBefore(channel, ready[j - 1])) {
+      ready[j] = ready[j - 1];
+      j--;
+    }
+    ready[j] = channel;
+  }
+
+  int32_t tokens = airtimeTokens;
+  bool sending = false;
+  for (size_t i = 0; i < readyCount; i++) {
+    const ChannelPolicy& policy = channelPolicies[static_cast<size_t>(ready[i])];
+    if (policy.priority != Priority::Critical && tokens < policy.size) {
+      continue; // stays pending, its deadline keeps it near the front next time
+    }
+    tokens -= policy.size;
+    sendChannel(ready[i], false);
+    markSent(ready[i], now);
+    sending = true;
+  }
+
+  // A slot without spare budget is retried, the window then stretches with the congestion
+  const uint32_t sinceSlot = now - lastKeyframeSlotAt;
+  const bool slotDue = sinceSlot >= keyframeSlotLimit || (sending && sinceSlot >= keyframeSlotInterval);
+  if (slotDue && tokens >= keyframeReserveBytes) {
+    const Channel channel = static_cast<Channel>(keyframeCursor);
+    lastKeyframeSlotAt = now;
+    keyframeCursor = (keyframeCursor + 1) % channelCount;
+    // A pending channel is about to go out in full anyway
+    if (!channelStates[static_cast<size_t>(channel)].pending) {
+      sendChannel(channel, true);
+      markSent(channel, now);
+    }
+  }
+}
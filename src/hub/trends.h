@@ -0,0 +1,102 @@
+#pragma once
+
+#include <Arduino.h>
+#include <cstdint>
+#include "message.h"
+#include "dcsbios_handler.h"
+
+// Rate of change of the continuous values, estimated once per export frame and sent along with
+// the values so gauges can keep their needles moving between frames (dead_reckoning.h)
+static const uint8_t trendStillFrames = 2; // unchanged export frames before a value counts as stopped
+
+struct Trend {
+  int32_t value;
+  uint32_t changedAt;
+  int32_t rate;      // raw units per second
+  int16_t sentRate;
+  uint8_t stillFrames;
+  bool seeded;
+};
+
+static Trend trends[trendFieldCount];
+static uint8_t trendsDue = 0; // TrendField bits to send with the next flush
+static uint32_t lastTrendFrameAt = 0;
+
+static constexpr uint8_t trendBit(TrendField field) {
+  return (uint8_t)(1u << static_cast<uint8_t>(field));
+}
+
+// Called when a value goes out. A gauge keeps applying the last rate it got, so the rate is only
+// resent when it drifted from that by more than trendTolerance (or on keyframes).
+static const int32_t trendTolerance = 64; // raw units per second, or 1/8 of the rate if larger
+
+static void markTrendDue(TrendField field, bool keyframe) {
+  const Trend& t = trends[static_cast<size_t>(field)];
+  const int32_t drift = abs(t.rate - t.sentRate);
+  if (keyframe || drift > max(trendTolerance, (int32_t)abs(t.sentRate) / 8) || (t.rate == 0 && t.sentRate != 0)) {
+    trendsDue |= trendBit(field);
+  }
+}
+
+// Raw 16 bit values wrap, the bank goes round; the altitude does not
+static void updateTrend(TrendField field, int32_t value, uint32_t now, bool wraps = true) {
+  Trend& t = trends[static_cast<size_t>(field)];
+  if (!t.seeded) {
+    t.seeded = true;
+    t.value = value;
+    t.changedAt = now;
+    t.stillFrames = trendStillFrames;
+    return;
+  }
+
+  if (value == t.value) {
+    if (t.stillFrames < trendStillFrames && ++t.stillFrames == trendStillFrames) {
+      t.rate = 0;
+    }
+    // The channel itself is not sent while unchanged, the stop has to go out on its own
+    if (t.rate == 0 && t.sentRate != 0) {
+      trendsDue |= trendBit(field);
+    }
+    return;
+  }
+
+  const int32_t delta = wraps ? (int16_t)(uint16_t)(value - t.value) : value - t.value;
+  const bool moving = t.stillFrames < trendStillFrames;
+  const uint32_t elapsed = moving ? now - t.changedAt : now - lastTrendFrameAt;
+  if (elapsed > 0) {
+    const int32_t instant = delta * 1000 / (int32_t)elapsed;
+    t.rate = moving ? (t.rate + instant) / 2 : instant;
+    t.rate = constrain(t.rate, (int32_t)INT16_MIN, (int32_t)INT16_MAX);
+  }
+  t.value = value;
+  t.changedAt = now;
+  t.stillFrames = 0;
+}
+
+static void updateTrends(const CockpitState& state, uint32_t now) {
+  updateTrend(TrendField::Airspeed, state.airspeed, now);
+  updateTrend(TrendField::VerticalVelocityIndicator, state.vsi, now);
+  updateTrend(TrendField::Altitude, altimeterAltitude(state.altimeter), now, false);
+  updateTrend(TrendField::SaiBank, state.sai.bank, now);
+  updateTrend(TrendField::SaiPitch, state.sai.pitch, now);
+  updateTrend(TrendField::SaiSlipBall, state.sai.slipBall, now);
+  updateTrend(TrendField::SaiRateOfTurn, state.sai.rateOfTurn, now);
+  lastTrendFrameAt = now;
+}
+
+// Fills `m` with the due rates, returns the number of bytes to send or 0 when nothing is due
+static size_t takeTrends(TrendMessage& m) {
+  if (!trendsDue) {
+    return 0;
+  }
+  m.fields = trendsDue;
+  size_t count = 0;
+  for (size_t i = 0; i < trendFieldCount; i++) {
+    if (trendsDue & (1u << i)) {
+      trends[i].sentRate = (int16_t)trends[i].rate;
+      m.rates[count++] = trends[i].sentRate;
+    }
+  }
+  trendsDue = 0;
+  return offsetof(TrendMessage, rates) + count * sizeof(int16_t);
+}
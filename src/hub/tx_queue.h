@@ -0,0 +1,106 @@
+#pragma once
+
+#include <Arduino.h>
+#include <cstdint>
+#include <cstring>
+#include "message.h"
+#include "fec.h"
+
+// Records waiting for the radio, at most one per key: Integer messages are keyed by ValueName,
+// parity by the category it protects, everything else by category, the IFEI layouts sharing
+// one key. A newer record replaces the queued one and moves to the back, so a stale value never
+// goes out after a fresher one, and a burst that finds the driver busy only costs the values it
+// superseded.
+static const size_t txQueueKeyCount = messageCategoryCount + valueNameCount + fecProtectedCount;
+static const size_t txRecordMaxSize = MAX_FRAME_SIZE - sizeof(MessageHeader) - 2;
+
+static size_t txKeyOf(const uint8_t* message) {
+  const MessageCategory category = reinterpret_cast<const MessageHeader*>(message)->category;
+  switch (category) {
+  case MessageCategory::Integer:
+    return messageCategoryCount + static_cast<size_t>(reinterpret_cast<const IntegerMessage*>(message)->name);
+  case MessageCategory::Parity:
+    return messageCategoryCount + valueNameCount + fecIndex(reinterpret_cast<const ParityMessage*>(message)->protects);
+  case MessageCategory::IFEIDelta:
+  case MessageCategory::IFEICompact:
+    return static_cast<size_t>(MessageCategory::IFEI);
+  default:
+    return static_cast<size_t>(category);
+  }
+}
+
+class TxQueue {
+public:
+  void put(const void* message, size_t len) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(message);
+    Slot& s = slots[txKeyOf(bytes)];
+    if (s.queued) {
+      superseded++;
+    } else {
+      count++;
+    }
+    s.queued = true;
+    s.order = nextOrder++;
+    s.len = (uint8_t)len;
+    memcpy(s.data, bytes, len);
+  }
+
+  bool empty() const {
+    return count == 0;
+  }
+
+  // The record waiting under a category (not Integer), nullptr when there is none
+  const uint8_t* queued(MessageCategory category) const {
+    const Slot& s = slots[static_cast<size_t>(category)];
+    return s.queued ? s.data : nullptr;
+  }
+
+  // Appends the oldest records to `frame` while they fit and returns how many. They stay queued
+  // until commit(), so a frame the driver refused is built again from the latest records.
+  uint8_t take(SuperframeMessage& frame, size_t& used) {
+    takenCount = 0;
+    uint32_t after = 0;
+    bool first = true;
+    while (takenCount < count) {
+      int next = -1;
+      for (size_t i = 0; i < txQueueKeyCount; i++) {
+        const Slot& s = slots[i];
+        if (s.queued && (first || (int32_t)(s.order - after) > 0) &&
+            (next < 0 || (int32_t)(s.order - slots[next].order) < 0)) {
+          next = (int)i;
+        }
+      }
+      if (next < 0 || !appendSuperframeRecord(frame, used, slots[next].data, slots[next].len)) {
+        break;
+      }
+      taken[takenCount++] = (uint8_t)next;
+      after = slots[next].order;
+      first = false;
+    }
+    return takenCount;
+  }
+
+  void commit() {
+    for (uint8_t i = 0; i < takenCount; i++) {
+      slots[taken[i]].queued = false;
+    }
+    count -= takenCount;
+    takenCount = 0;
+  }
+
+  uint32_t superseded = 0; // records replaced by a newer one before they went out
+
+private:
+  struct Slot {
+    bool queued;
+    uint8_t len;
+    uint32_t order;
+    uint8_t data[txRecordMaxSize];
+  };
+
+  Slot slots[txQueueKeyCount]{};
+  uint8_t taken[txQueueKeyCount];
+  uint8_t takenCount = 0;
+  uint8_t count = 0;
+  uint32_t nextOrder = 0;
+};
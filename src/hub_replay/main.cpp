@@ -0,0 +1,260 @@
+// Replays a recorded DCS-BIOS export stream through the hub's parsing, diffing and
+// scheduling code on the host, and reports what would have gone on air.
+//
+//   pio run -e hub_replay
+//   .pio/build/hub_replay/program capture.bin [--frames out.hfl] [--text out.txt]
+//                                 [--fps 30] [--baud 250000] [--realtime]
+//
+// capture.bin is the raw export byte stream (what DCS-BIOS writes to the hub's COM port).
+// --frames writes a frame log (include/frame_log.h), --text a diffable hex listing.
+// --realtime paces the replay to the wall clock instead of running it as fast as possible.
+//
+// The hub_udp env builds the same harness on the UDP transport (include/transport_udp.h),
+// realtime by default, so gauge_monitor processes on the same host receive the frames:
+//
+//   .pio/build/gauge_monitor/program --seconds 30 &
+//   .pio/build/hub_udp/program capture.bin
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../hub/main.cpp"
+#include "frame_log.h"
+
+struct CategoryCounters {
+  uint32_t frames;  // sent as a bare frame
+  uint32_t records; // carried inside a superframe
+  uint64_t bytes;
+};
+
+static CategoryCounters categoryCounters[messageCategoryCount];
+static uint32_t framesSent = 0;
+static uint64_t bytesSent = 0;
+static FILE* framesFile = nullptr;
+static FILE* textFile = nullptr;
+
+// Longest gap between two full state records of the same value: the worst case wait of a gauge
+// that (re)joins at a random time. Integer messages are tracked per ValueName, IFEIDelta does
+// not count as it needs an earlier keyframe.
+struct RefreshGap {
+  bool seen;
+  uint32_t lastAt;
+  uint32_t maxGap;
+};
+
+static RefreshGap refreshGaps[messageCategoryCount + 256];
+
+static void recordRefresh(const uint8_t* message) {
+  const MessageCategory category = reinterpret_cast<const MessageHeader*>(message)->category;
+  size_t key = (size_t)category;
+  switch (category) {
+  case MessageCategory::IFEIDelta:
+  case MessageCategory::Superframe:
+  case MessageCategory::Attitude:
+    return;
+  case MessageCategory::IFEICompact:
+    key = (size_t)MessageCategory::IFEI;
+    break;
+  case MessageCategory::Integer:
+    key = messageCategoryCount + (size_t)reinterpret_cast<const IntegerMessage*>(message)->name;
+    break;
+  default:
+    break;
+  }
+  if (key >= sizeof(refreshGaps) / sizeof(refreshGaps[0])) {
+    return;
+  }
+  RefreshGap& gap = refreshGaps[key];
+  if (gap.seen) {
+    gap.maxGap = std::max(gap.maxGap, ReplayHost::nowMs - gap.lastAt);
+  }
+  gap.seen = true;
+  gap.lastAt = ReplayHost::nowMs;
+}
+
+static void onFrameSent(const uint8_t* mac, const uint8_t* data, size_t len) {
+  framesSent++;
+  bytesSent += len;
+
+  const size_t category = (size_t)reinterpret_cast<const MessageHeader*>(data)->category;
+  if (category < messageCategoryCount) {
+    categoryCounters[category].frames++;
+    categoryCounters[category].bytes += len;
+  }
+  if (category == (size_t)MessageCategory::Superframe) {
+    forEachMessage(data, (int)len, [](const uint8_t* record, int recordLen) {
+      const size_t c = (size_t)reinterpret_cast<const MessageHeader*>(record)->category;
+      if (c < messageCategoryCount) {
+        categoryCounters[c].records++;
+      }
+    });
+  }
+  forEachMessage(data, (int)len, [](const uint8_t* message, int messageLen) { recordRefresh(message); });
+
+  if (framesFile) {
+    const FrameLogRecord record{ ReplayHost::nowMs, (uint8_t)len };
+    fwrite(&record, sizeof(record), 1, framesFile);
+    fwrite(data, 1, len, framesFile);
+  }
+  if (textFile) {
+    fprintf(textFile, "%8u %3zu ", (unsigned)ReplayHost::nowMs, len);
+    for (size_t i = 0; i < len; i++) {
+      fprintf(textFile, "%02x", data[i]);
+    }
+    fputc('\n', textFile);
+  }
+}
+
+static bool readFile(const char* path, std::vector<uint8_t>& out) {
+  FILE* f = fopen(path, "rb");
+  if (!f) {
+    return false;
+  }
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+    out.insert(out.end(), buf, buf + n);
+  }
+  fclose(f);
+  return true;
+}
+
+static void usage() {
+  fprintf(stderr, "usage: hub_replay capture.bin [--frames out.hfl] [--text out.txt] [--fps 30] [--baud 250000] [--realtime]\n");
+}
+
+int main(int argc, char** argv) {
+#if defined(TRANSPORT_UDP)
+  ReplayHost::realtime = true;
+#endif
+  const char* input = nullptr;
+  const char* framesPath = nullptr;
+  const char* textPath = nullptr;
+  for (int i = 1; i < argc; i++) {
+    const bool hasValue = i + 1 < argc;
+    if (strcmp(argv[i], "--frames") == 0 && hasValue) {
+      framesPath = argv[++i];
+    } else if (strcmp(argv[i], "--text") == 0 && hasValue) {
+      textPath = argv[++i];
+    } else if (strcmp(argv[i], "--fps") == 0 && hasValue) {
+      ReplayHost::frameIntervalMs = 1000 / std::max(1, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--baud") == 0 && hasValue) {
+      ReplayHost::bytesPerSecond = std::max(10, atoi(argv[++i])) / 10;
+    } else if (strcmp(argv[i], "--realtime") == 0) {
+      ReplayHost::realtime = true;
+    } else if (!input && argv[i][0] != '-') {
+      input = argv[i];
+    } else {
+      usage();
+      return 2;
+    }
+  }
+  if (!input) {
+    usage();
+    return 2;
+  }
+
+  std::vector<uint8_t> bytes;
+  if (!readFile(input, bytes)) {
+    fprintf(stderr, "cannot read %s\n", input);
+    return 1;
+  }
+  ReplayHost::load(std::move(bytes));
+
+  if (framesPath) {
+    framesFile = fopen(framesPath, "wb");
+    if (!framesFile) {
+      fprintf(stderr, "cannot write %s\n", framesPath);
+      return 1;
+    }
+    fwrite(FRAME_LOG_MAGIC, 1, FRAME_LOG_MAGIC_SIZE, framesFile);
+  }
+  if (textPath) {
+    textFile = fopen(textPath, "w");
+    if (!textFile) {
+      fprintf(stderr, "cannot write %s\n", textPath);
+      return 1;
+    }
+  }
+
+#if defined(TRANSPORT_UDP)
+  Transport::sendObserver = onFrameSent;
+#else
+  ReplayHost::onSend = onFrameSent;
+#endif
+  setup();
+  ReplayHost::startWallClock();
+
+  // One hub loop() per virtual millisecond, plus a second after the stream ends to drain
+  const uint32_t startMs = ReplayHost::nowMs;
+  const auto wallStart = std::chrono::steady_clock::now();
+  uint32_t drainUntil = 0;
+  uint64_t parseNanos = 0;
+  for (;;) {
+    // Parsed ahead of loop() to time the parser alone, loop() then finds nothing new this ms
+    const auto parseStart = std::chrono::steady_clock::now();
+    serviceIngest();
+    parseNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - parseStart).count();
+    loop();
+    ReplayHost::nowMs++;
+    if (ReplayHost::realtime) {
+      const int64_t dueUs = (int64_t)(ReplayHost::nowMs - startMs) * 1000;
+      const int64_t aheadUs = dueUs - ReplayHost::wallMicros();
+      if (aheadUs > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(aheadUs));
+      }
+    }
+    if (ReplayHost::done()) {
+      if (drainUntil == 0) {
+        drainUntil = ReplayHost::nowMs + 1000;
+      } else if ((int32_t)(ReplayHost::nowMs - drainUntil) >= 0) {
+        break;
+      }
+    }
+  }
+  const double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+  const double virtualSeconds = (ReplayHost::nowMs - startMs) / 1000.0;
+  const double parseSeconds = parseNanos / 1e9;
+
+  if (framesFile) {
+    fclose(framesFile);
+  }
+  if (textFile) {
+    fclose(textFile);
+  }
+
+  printf("input        %zu bytes, %zu export frames, %.1f s simulated in %.2f s\n",
+         ReplayHost::stream.size(), ReplayHost::frameStarts.size(), virtualSeconds, wallSeconds);
+  printf("parser       %llu bytes in %.3f s, %.2f MB/s\n", (unsigned long long)ingestStats.bytesParsed,
+         parseSeconds, parseSeconds > 0 ? ingestStats.bytesParsed / parseSeconds / 1e6 : 0.0);
+  printf("dispatch     %llu listener calls\n", (unsigned long long)ReplayHost::listenerCalls);
+  printf("interest     %u of %u words in range used, %.1f%% of their payload skipped\n", (unsigned)exportWordsUsed,
+         (unsigned)exportWordsSeen, exportWordsSeen ? 100.0 * (exportWordsSeen - exportWordsUsed) / exportWordsSeen : 0.0);
+  printf("broadcast    %u frames, %llu bytes, %.1f frames/s, %.0f bytes/s\n", (unsigned)framesSent,
+         (unsigned long long)bytesSent, framesSent / virtualSeconds, bytesSent / virtualSeconds);
+  printf("tx queue     %u records superseded while queued, %u frames refused by the driver\n",
+         (unsigned)txQueue.superseded, (unsigned)sendsRefused);
+  uint32_t convergence = 0;
+  for (const RefreshGap& gap : refreshGaps) {
+    convergence = std::max(convergence, gap.maxGap);
+  }
+  printf("convergence  %u ms worst case for a gauge joining late (keyframe window %u ms)\n",
+         (unsigned)convergence, (unsigned)keyframeWindow);
+  printf("\n%-14s %8s %8s %10s\n", "category", "frames", "records", "bytes");
+  for (size_t i = 0; i < messageCategoryCount; i++) {
+    const CategoryCounters& c = categoryCounters[i];
+    if (c.frames == 0 && c.records == 0) {
+      continue;
+    }
+    printf("%-14s %8u %8u %10llu\n", categoryName(static_cast<MessageCategory>(i)), (unsigned)c.frames, (unsigned)c.records,
+           (unsigned long long)c.bytes);
+  }
+  Print out;
+  printf("\nlast telemetry interval\n");
+  printTelemetry(out, hubStats.latest());
+  return 0;
+}
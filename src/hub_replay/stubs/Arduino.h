@@ -0,0 +1,110 @@
+#pragma once
+
+// Minimal Arduino core for building the hub on the host, time comes from ReplayHost
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "replay_host.h"
+
+using std::max;
+using std::min;
+
+inline uint32_t millis() {
+  return ReplayHost::nowMs;
+}
+
+inline uint32_t micros() {
+  return ReplayHost::nowMs * 1000;
+}
+
+inline void delay(uint32_t ms) {
+  ReplayHost::nowMs += ms;
+}
+
+// Single threaded on the host, critical sections are no-ops
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) (void)(mux)
+#define portEXIT_CRITICAL(mux) (void)(mux)
+#define portENTER_CRITICAL_ISR(mux) (void)(mux)
+#define portEXIT_CRITICAL_ISR(mux) (void)(mux)
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+template<typename T>
+inline T constrain(T x, T low, T high) {
+  return x < low ? low : (x > high ? high : x);
+}
+
+inline size_t strlcpy(char* dst, const char* src, size_t size) {
+  const size_t len = strlen(src);
+  if (size > 0) {
+    const size_t n = len < size - 1 ? len : size - 1;
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+  }
+  return len;
+}
+
+class Print {
+public:
+  virtual ~Print() = default;
+  virtual size_t write(uint8_t c) {
+    return fputc(c, stdout) == EOF ? 0 : 1;
+  }
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    const int n = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    return print(buf) * (n > 0);
+  }
+  size_t print(const char* s) {
+    size_t n = 0;
+    while (*s) {
+      n += write((uint8_t)*s++);
+    }
+    return n;
+  }
+  size_t println(const char* s = "") {
+    return print(s) + write('\n');
+  }
+};
+
+class Stream : public Print {
+public:
+  virtual int available() {
+    return 0;
+  }
+  virtual int read() {
+    return -1;
+  }
+};
+
+// DCS-BIOS serial port, fed from the recorded stream
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long) {}
+  int available() override {
+    return ReplayHost::available() ? 1 : 0;
+  }
+  int read() override {
+    return ReplayHost::available() ? ReplayHost::stream[ReplayHost::cursor++] : -1;
+  }
+  size_t read(uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (n < size && ReplayHost::available()) {
+      buffer[n++] = ReplayHost::stream[ReplayHost::cursor++];
+    }
+    return n;
+  }
+};
+
+inline HardwareSerial Serial;
@@ -0,0 +1,121 @@
+#pragma once
+
+// Host stand-in for the DCS-BIOS Arduino library: same protocol parser state machine and
+// listener dispatch, without the Arduino dependencies. The hub decodes through its own export
+// table (dcsbios_handler.h), so the library's buffer classes are not needed here. Control
+// addresses come from the real library's Addresses.h (see the hub_replay env in platformio.ini).
+
+#include <Arduino.h>
+#include <Addresses.h>
+
+namespace DcsBios {
+
+class ExportStreamListener {
+public:
+  ExportStreamListener(unsigned int firstAddressOfInterest, unsigned int lastAddressOfInterest)
+      : firstAddressOfInterest(firstAddressOfInterest), lastAddressOfInterest(lastAddressOfInterest) {
+    next = first;
+    first = this;
+  }
+  virtual ~ExportStreamListener() = default;
+
+  virtual void onDcsBiosWrite(unsigned int address, unsigned int value) {}
+  virtual void onConsistentData() {}
+  virtual void loop() {}
+
+  static void handleDcsBiosWrite(unsigned int address, unsigned int value) {
+    for (ExportStreamListener* l = first; l; l = l->next) {
+      if (address >= l->firstAddressOfInterest && address <= l->lastAddressOfInterest) {
+        ReplayHost::listenerCalls++;
+        l->onDcsBiosWrite(address, value);
+      }
+    }
+    // The update counter is written last in every export frame
+    if (address == 0xfffe) {
+      for (ExportStreamListener* l = first; l; l = l->next) {
+        l->onConsistentData();
+      }
+    }
+  }
+
+  static void loopAll() {
+    for (ExportStreamListener* l = first; l; l = l->next) {
+      l->loop();
+    }
+  }
+
+protected:
+  unsigned int firstAddressOfInterest;
+  unsigned int lastAddressOfInterest;
+
+private:
+  ExportStreamListener* next;
+  static inline ExportStreamListener* first = nullptr;
+};
+
+class ProtocolParser {
+public:
+  void processChar(uint8_t c) {
+    switch (state) {
+    case State::WaitForSync:
+      break;
+    case State::AddressLow:
+      address = c;
+      state = State::AddressHigh;
+      break;
+    case State::AddressHigh:
+      address |= c << 8;
+      state = address != 0x5555 ? State::CountLow : State::WaitForSync;
+      break;
+    case State::CountLow:
+      count = c;
+      state = State::CountHigh;
+      break;
+    case State::CountHigh:
+      count |= c << 8;
+      state = State::DataLow;
+      break;
+    case State::DataLow:
+      data = c;
+      count--;
+      state = State::DataHigh;
+      break;
+    case State::DataHigh:
+      data |= c << 8;
+      count--;
+      ExportStreamListener::handleDcsBiosWrite(address, data);
+      address += 2;
+      state = count == 0 ? State::AddressLow : State::DataLow;
+      break;
+    }
+
+    syncBytes = c == 0x55 ? syncBytes + 1 : 0;
+    if (syncBytes == 4) {
+      state = State::AddressLow;
+      syncBytes = 0;
+    }
+  }
+
+private:
+  enum class State : uint8_t { WaitForSync, AddressLow, AddressHigh, CountLow, CountHigh, DataLow, DataHigh };
+  State state = State::WaitForSync;
+  unsigned int address = 0;
+  unsigned int count = 0;
+  unsigned int data = 0;
+  uint8_t syncBytes = 0;
+};
+
+inline ProtocolParser parser;
+
+inline void setup() {
+  Serial.begin(250000);
+}
+
+inline void loop() {
+  while (Serial.available()) {
+    parser.processChar((uint8_t)Serial.read());
+  }
+  ExportStreamListener::loopAll();
+}
+
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#define WIFI_STA 1
+
+class WiFiClass {
+public:
+  bool mode(int) {
+    return true;
+  }
+};
+
+inline WiFiClass WiFi;
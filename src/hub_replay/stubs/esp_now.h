@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "replay_host.h"
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+typedef enum {
+  ESP_NOW_SEND_SUCCESS = 0,
+  ESP_NOW_SEND_FAIL,
+} esp_now_send_status_t;
+
+struct esp_now_recv_info_t {
+  uint8_t* src_addr;
+  uint8_t* des_addr;
+};
+
+typedef void (*esp_now_send_cb_t)(const uint8_t* mac, esp_now_send_status_t status);
+typedef void (*esp_now_recv_cb_t)(const esp_now_recv_info_t* info, const uint8_t* data, int len);
+
+namespace ReplayHost {
+inline esp_now_send_cb_t sendCallback = nullptr;
+}
+
+struct esp_now_peer_info_t {
+  uint8_t peer_addr[6];
+  uint8_t channel;
+  bool encrypt;
+};
+
+inline esp_err_t esp_now_init() {
+  return ESP_OK;
+}
+
+inline esp_err_t esp_now_add_peer(const esp_now_peer_info_t*) {
+  return ESP_OK;
+}
+
+inline esp_err_t esp_now_del_peer(const uint8_t*) {
+  return ESP_OK;
+}
+
+inline bool esp_now_is_peer_exist(const uint8_t*) {
+  return true;
+}
+
+// Nothing is ever received on the host
+inline esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t) {
+  return ESP_OK;
+}
+
+inline esp_err_t esp_now_register_send_cb(esp_now_send_cb_t cb) {
+  ReplayHost::sendCallback = cb;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_now_send(const uint8_t* mac, const uint8_t* data, size_t len) {
+  if (ReplayHost::onSend) {
+    ReplayHost::onSend(mac, data, len);
+  }
+  if (ReplayHost::sendCallback) {
+    ReplayHost::sendCallback(mac, ESP_NOW_SEND_SUCCESS);
+  }
+  return ESP_OK;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstdint>
+#include "replay_host.h"
+
+inline int64_t esp_timer_get_time() {
+  return ReplayHost::timerMicros();
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "esp_now.h"
+
+#define WIFI_SECOND_CHAN_NONE 0
+
+inline esp_err_t esp_wifi_set_channel(uint8_t, int) {
+  return ESP_OK;
+}
+
+inline esp_err_t esp_wifi_set_max_tx_power(int8_t) {
+  return ESP_OK;
+}
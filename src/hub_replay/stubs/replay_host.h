@@ -0,0 +1,81 @@
+#pragma once
+
+// Host-side state shared by the Arduino/ESP-NOW/DCS-BIOS stubs of the replay harness
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ReplayHost {
+
+// Virtual clock, advanced by the harness and by delay()
+inline uint32_t nowMs = 0;
+
+// With realtime set the virtual clock is paced to the wall clock (runs over the UDP transport)
+// and esp_timer_get_time() reads the wall clock, for sub-millisecond timestamps
+inline bool realtime = false;
+inline std::chrono::steady_clock::time_point wallOrigin;
+inline uint32_t wallOriginMs = 0;
+
+inline void startWallClock() {
+  wallOrigin = std::chrono::steady_clock::now();
+  wallOriginMs = nowMs;
+}
+
+inline int64_t wallMicros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - wallOrigin).count();
+}
+
+inline int64_t timerMicros() {
+  return realtime ? (int64_t)wallOriginMs * 1000 + wallMicros() : (int64_t)nowMs * 1000;
+}
+
+// Recorded DCS-BIOS export stream. Frame n (starting at a 0x55 0x55 0x55 0x55 sync) is
+// released at n * frameIntervalMs, its bytes then trickle in at the serial byte rate.
+inline std::vector<uint8_t> stream;
+inline std::vector<size_t> frameStarts;
+inline size_t cursor = 0;
+inline size_t currentFrame = 0;
+inline uint32_t frameIntervalMs = 33;
+inline uint32_t bytesPerSecond = 25000; // 250000 baud, 8N1
+
+inline void load(std::vector<uint8_t> bytes) {
+  stream = std::move(bytes);
+  frameStarts.clear();
+  for (size_t i = 0; i + 3 < stream.size(); i++) {
+    if (stream[i] == 0x55 && stream[i + 1] == 0x55 && stream[i + 2] == 0x55 && stream[i + 3] == 0x55) {
+      frameStarts.push_back(i);
+      i += 3;
+    }
+  }
+  cursor = 0;
+  currentFrame = 0;
+}
+
+inline uint32_t arrivalMs(size_t index) {
+  while (currentFrame + 1 < frameStarts.size() && frameStarts[currentFrame + 1] <= index) {
+    currentFrame++;
+  }
+  if (frameStarts.empty() || index < frameStarts[0]) {
+    return 0;
+  }
+  const size_t start = frameStarts[currentFrame];
+  return currentFrame * frameIntervalMs + (uint32_t)((index - start) * 1000ULL / bytesPerSecond);
+}
+
+inline bool available() {
+  return cursor < stream.size() && arrivalMs(cursor) <= nowMs;
+}
+
+inline bool done() {
+  return cursor >= stream.size();
+}
+
+// Counters reported by the harness
+inline uint64_t listenerCalls = 0; // ExportStreamListener::onDcsBiosWrite() invocations
+
+// Every esp_now_send() ends up here
+inline void (*onSend)(const uint8_t* mac, const uint8_t* data, size_t len) = nullptr;
+
+}
@@ -9,12 +9,12 @@ Stability design:
 */
 
 #include <Arduino.h>
-#include <WiFi.h>
-#include <esp_wifi.h>
-#include <esp_now.h>
 #include <TFT_eSPI.h>
 #include "TFT_helper.h"
 #include "message.h"
+#include "transport.h"
+#include "link_stats.h"
+#include "subscription.h"
 
 // ── Assets ─────────────────────────────────────────────────────────────────────
 #include "hydPressBackground.h" // uint16_t/uint8_t array (sized 240x240)
@@ -51,46 +51,55 @@ static inline int16_t map_hyd(uint16_t v) {
 void renderGauge(int16_t a1, int16_t a2);
 void bitTest();
 
-static void initEspNowClient() {
-  WiFi.mode(WIFI_STA);
-  esp_wifi_set_channel(ESP_CHANNEL, WIFI_SECOND_CHAN_NONE);
-  esp_wifi_set_max_tx_power(ESP_MAX_TX_POWER);
-
-  if (esp_now_init() != ESP_OK) {
-    Serial.println("ESP-NOW init failed");
+static LinkStats linkStats;
+static LatencyStats latencyStats;
+static SubscriptionAnnouncer subscription(
+  categoryBit(MessageCategory::Integer),
+  valueBit(ValueName::HydraulicPressureLeft) | valueBit(ValueName::HydraulicPressureRight) | valueBit(ValueName::InstrumentLighting));
+
+static void onMessage(const uint8_t* data, int len) {
+  const MessageHeader* hdr = reinterpret_cast<const MessageHeader*>(data);
+  IntegerMessage message{};
+  switch (hdr->category) {
+  case MessageCategory::Integer:
+    if (len != (int)sizeof(IntegerMessage)) {
+      return;
+    }
+    message = *reinterpret_cast<const IntegerMessage *>(data);
+    if (message.name == ValueName::HydraulicPressureLeft) {
+      raw1 = message.value;
+      dirty = true;
+    }
+    if (message.name == ValueName::HydraulicPressureRight) {
+      raw2 = message.value;
+      dirty = true;
+    }
+    if (message.name == ValueName::InstrumentLighting) {
+      brightness = message.value;
+      dirty = true;
+    }
+    break;
+  default:
     return;
   }
+}
 
-  esp_now_register_recv_cb([](const esp_now_recv_info_t* info, const uint8_t* data, int len) {
-    if (len < (int)sizeof(MessageHeader)) {
-      return;
-    }
+static void initTransport() {
+  if (!Transport::begin()) {
+    Serial.println("Transport init failed");
+    return;
+  }
 
-    const MessageHeader* hdr = reinterpret_cast<const MessageHeader*>(data);
-    IntegerMessage message{};
-    switch (hdr->category) {
-    case MessageCategory::Integer:
-      if (len != (int)sizeof(IntegerMessage)) {
-        return;
-      }
-      message = *reinterpret_cast<const IntegerMessage *>(data);
-      if (message.name == ValueName::HydraulicPressureLeft) {
-        raw1 = message.value;
-        dirty = true;
-      }
-      if (message.name == ValueName::HydraulicPressureRight) {
-        raw2 = message.value;
-        dirty = true;
-      }
-      if (message.name == ValueName::InstrumentLighting) {
-        brightness = message.value;
-        dirty = true;
-      }
-      break;
-    default:
-      return;
+  Transport::onReceive([](const uint8_t* mac, const uint8_t* data, int len) {
+    latencyStats.recordFrame(data, len);
+    linkStats.recordFrame(data, len);
+    forEachMessage(data, len, onMessage);
+    if (dirty) {
+      latencyStats.markPending();
     }
   });
+  subscription.begin();
+  latencyStats.begin();
 }
 
 // ── Setup ──────────────────────────────────────────────────────────────────────
@@ -123,11 +132,16 @@ void setup() {
   // Initial paint
   renderGauge(map_hyd(raw1), map_hyd(raw2));
 
-  initEspNowClient();
+  initTransport();
 }
 
 // ── Main loop ──────────────────────────────────────────────────────────────────
 void loop() {
+  Transport::poll();
+  linkStats.serviceConsole(Serial, &latencyStats);
+  subscription.service(millis());
+  latencyStats.service(millis());
+
   const uint32_t now = millis();
   const bool frameDue   = (now - lastFrameMs) >= FRAME_INTERVAL_MS;
 
@@ -155,6 +169,7 @@ void renderGauge(int16_t angle1, int16_t angle2) {
   needle2.pushRotated(&gaugeBack, angle2, TFT_TRANSPARENT);
 
   gaugeBack.pushSprite(0, 0);
+  latencyStats.displayed();
 }
 
 // ── Manual sweep test (optional) ───────────────────────────────────────────────
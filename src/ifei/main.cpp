@@ -1,47 +1,94 @@
 #include <Arduino.h>
-#include <WiFi.h>
-#include <esp_wifi.h>
-#include <esp_now.h>
 #include "message.h"
+#include "transport.h"
+#include "ifei_codec.h"
+#include "link_stats.h"
+#include "subscription.h"
 #include "renderer.h"
 
+static portMUX_TYPE msgMux = portMUX_INITIALIZER_UNLOCKED;
 static IfeiMessage lastMessage{};
-static volatile uint32_t lastMessageMs = 0;
+static volatile bool hasNewMessage = false;
 
-static void initEspNowClient() {
-  WiFi.mode(WIFI_STA);
-  esp_wifi_set_channel(ESP_CHANNEL, WIFI_SECOND_CHAN_NONE);
-  esp_wifi_set_max_tx_power(ESP_MAX_TX_POWER);
+static LinkStats linkStats;
+static LatencyStats latencyStats;
+static SubscriptionAnnouncer subscription(
+  categoryBit(MessageCategory::IFEI) | categoryBit(MessageCategory::IFEIDelta) | categoryBit(MessageCategory::IFEICompact),
+  0);
 
-  if (esp_now_init() != ESP_OK) {
-    Serial.println("ESP-NOW init failed");
-    return;
+static void onMessage(const uint8_t* data, int len) {
+  const MessageHeader* hdr = reinterpret_cast<const MessageHeader*>(data);
+  if (hdr->category == MessageCategory::IFEI) {
+    if (len != (int)sizeof(IfeiMessage)) {
+      return;
+    }
+    portENTER_CRITICAL_ISR(&msgMux);
+    lastMessage = *reinterpret_cast<const IfeiMessage *>(data);
+    portEXIT_CRITICAL_ISR(&msgMux);
+    hasNewMessage = true;
   }
-
-  esp_now_register_recv_cb([](const uint8_t* mac, const uint8_t* data, int len) {
-    if (len < (int)sizeof(MessageHeader)) {
+  if (hdr->category == MessageCategory::IFEICompact) {
+    if (len != (int)sizeof(IfeiCompactMessage)) {
       return;
     }
+    IfeiMessage decoded;
+    decodeIfeiCompact(*reinterpret_cast<const IfeiCompactMessage *>(data), decoded);
+    portENTER_CRITICAL_ISR(&msgMux);
+    lastMessage = decoded;
+    portEXIT_CRITICAL_ISR(&msgMux);
+    hasNewMessage = true;
+  }
+  if (hdr->category == MessageCategory::IFEIDelta) {
+    portENTER_CRITICAL_ISR(&msgMux);
+    const bool applied = applyIfeiDelta(lastMessage, data, len);
+    portEXIT_CRITICAL_ISR(&msgMux);
+    if (applied) {
+      hasNewMessage = true;
+    }
+  }
+}
+
+static void initTransport() {
+  if (!Transport::begin()) {
+    Serial.println("Transport init failed");
+    return;
+  }
 
-    const MessageHeader* hdr = reinterpret_cast<const MessageHeader*>(data);
-    if (hdr->category == MessageCategory::IFEI) {
-      lastMessage = *reinterpret_cast<const IfeiMessage *>(data);
-      lastMessageMs = millis();
+  Transport::onReceive([](const uint8_t* mac, const uint8_t* data, int len) {
+    latencyStats.recordFrame(data, len);
+    linkStats.recordFrame(data, len);
+    forEachMessage(data, len, onMessage);
+    if (hasNewMessage) {
+      latencyStats.markPending();
     }
   });
+  subscription.begin();
+  latencyStats.begin();
 }
 
 void setup() {
   Serial.begin(115200);
   initIfeiRenderer();
-  initEspNowClient();
+  initTransport();
 }
 
 void loop() {
+  Transport::poll();
+  linkStats.serviceConsole(Serial, &latencyStats);
+  subscription.service(millis());
+  latencyStats.service(millis());
+
   const uint32_t now = millis();
 
-  if (now - (uint32_t)lastMessageMs > 100) {
-    lastMessageMs = now;
-    renderIfeiMessage(lastMessage);
+  static uint32_t lastUpdatedAt = 0;
+  if (now - lastUpdatedAt >= 33 && hasNewMessage) {
+    hasNewMessage = false;
+    lastUpdatedAt = now;
+
+    portENTER_CRITICAL(&msgMux);
+    const IfeiMessage message = lastMessage;
+    portEXIT_CRITICAL(&msgMux);
+    renderIfeiMessage(message);
+    latencyStats.displayed();
   }
 }
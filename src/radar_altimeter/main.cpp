@@ -1,10 +1,10 @@
 #include <Arduino.h>
-#include <WiFi.h>
-#include <esp_wifi.h>
-#include <esp_now.h>
 #include <lvgl.h>
 #include "Display_ST77916.h"
 #include "message.h"
+#include "transport.h"
+#include "link_stats.h"
+#include "subscription.h"
 
 // LVGL bitmaps
 #include "radarAltBackground.c"
@@ -38,9 +38,14 @@ lv_obj_t *img_GreenLed;
 const int16_t center_x = DISP_WIDTH / 2;
 const int16_t center_y = DISP_HEIGHT / 2;
 
+static LatencyStats latencyStats;
+
 void my_disp_flush(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p) {
   LCD_addWindow(area->x1, area->y1, area->x2, area->y2, (uint16_t*)color_p);
   lv_disp_flush_ready(disp);
+  if (lv_disp_flush_is_last(disp)) {
+    latencyStats.displayed();
+  }
 }
 
 static RadarAltimeterMessage lastMessage = {};
@@ -81,34 +86,42 @@ void updateRendering() {
   setBrightness(brightness);
 }
 
-static void initEspNowClient() {
-  WiFi.mode(WIFI_STA);
-  esp_wifi_set_channel(ESP_CHANNEL, WIFI_SECOND_CHAN_NONE);
-  esp_wifi_set_max_tx_power(ESP_MAX_TX_POWER);
+static LinkStats linkStats;
+static SubscriptionAnnouncer subscription(
+  categoryBit(MessageCategory::RadarAltimeter) | categoryBit(MessageCategory::Integer),
+  valueBit(ValueName::InstrumentLighting));
 
-  if (esp_now_init() != ESP_OK) {
-    Serial.println("ESP-NOW init failed");
-    return;
+static void onMessage(const uint8_t* data, int len) {
+  const MessageHeader* hdr = reinterpret_cast<const MessageHeader*>(data);
+  if (hdr->category ==  MessageCategory::RadarAltimeter) {
+    lastMessage = *reinterpret_cast<const RadarAltimeterMessage *>(data);
+    hasNewMessage = true;
   }
-
-  esp_now_register_recv_cb([](const esp_now_recv_info_t* info, const uint8_t* data, int len) {
-    if (len < (int)sizeof(MessageHeader)) {
-      return;
-    }
-
-    const MessageHeader* hdr = reinterpret_cast<const MessageHeader*>(data);
-    if (hdr->category ==  MessageCategory::RadarAltimeter) {
-      lastMessage = *reinterpret_cast<const RadarAltimeterMessage *>(data);
+  if (hdr->category == MessageCategory::Integer) {
+    IntegerMessage message = *reinterpret_cast<const IntegerMessage *>(data);
+    if (message.name == ValueName::InstrumentLighting) {
+      brightness = message.value;
       hasNewMessage = true;
     }
-    if (hdr->category == MessageCategory::Integer) {
-      IntegerMessage message = *reinterpret_cast<const IntegerMessage *>(data);
-      if (message.name == ValueName::InstrumentLighting) {
-        brightness = message.value;
-        hasNewMessage = true;
-      }
+  }
+}
+
+static void initTransport() {
+  if (!Transport::begin()) {
+    Serial.println("Transport init failed");
+    return;
+  }
+
+  Transport::onReceive([](const uint8_t* mac, const uint8_t* data, int len) {
+    latencyStats.recordFrame(data, len);
+    linkStats.recordFrame(data, len);
+    forEachMessage(data, len, onMessage);
+    if (hasNewMessage) {
+      latencyStats.markPending();
     }
   });
+  subscription.begin();
+  latencyStats.begin();
 }
 
 void setup() {
@@ -192,10 +205,15 @@ void setup() {
   // Set pivot explicitly to hub center
   lv_img_set_pivot(img_radarAltNeedle, 36, 123);
 
-  initEspNowClient();
+  initTransport();
 }
 
 void loop() {
+  Transport::poll();
+  linkStats.serviceConsole(Serial, &latencyStats);
+  subscription.service(millis());
+  latencyStats.service(millis());
+
   static uint32_t lastTick = millis();
   const uint32_t now = millis();
   uint32_t dt = now - lastTick;
@@ -1,45 +1,108 @@
 #include <Arduino.h>
-#include <WiFi.h>
-#include <esp_wifi.h>
-#include <esp_now.h>
 #include "message.h"
+#include "transport.h"
+#include "link_stats.h"
+#include "fec.h"
+#include "subscription.h"
+#include "dead_reckoning.h"
+#include "attitude_codec.h"
 #include "renderer.h"
 
 static portMUX_TYPE msgMux = portMUX_INITIALIZER_UNLOCKED;
 static SaiMessage lastMessage{};
+static SaiMessage saiBase{}; // last full SaiMessage, what AttitudeMessage deltas apply to
 uint16_t brightness = 0;
 volatile bool hasNewMessage = false;
 
-static void initEspNowClient() {
-  WiFi.mode(WIFI_STA);
-  esp_wifi_set_channel(ESP_CHANNEL, WIFI_SECOND_CHAN_NONE);
-  esp_wifi_set_max_tx_power(ESP_MAX_TX_POWER);
+// Attitude and the slip ball keep moving between frames
+static DeadReckoner bank(MID_VALUE, true);
+static DeadReckoner pitch(MID_VALUE);
+static DeadReckoner slipBall(MID_VALUE);
+static DeadReckoner rateOfTurn(MID_VALUE);
 
-  if (esp_now_init() != ESP_OK) {
-    Serial.println("ESP-NOW init failed");
-    return;
-  }
+// The reckoners are fed by the receive callback too, under msgMux
+static bool advanceTrends(uint32_t now) {
+  portENTER_CRITICAL(&msgMux);
+  bool moved = bank.update(now);
+  moved = pitch.update(now) || moved;
+  moved = slipBall.update(now) || moved;
+  moved = rateOfTurn.update(now) || moved;
+  portEXIT_CRITICAL(&msgMux);
+  return moved;
+}
 
-  esp_now_register_recv_cb([](const uint8_t* mac, const uint8_t* data, int len) {
-    if (len < (int)sizeof(MessageHeader)) {
-      return;
-    }
+static LinkStats linkStats;
+static LatencyStats latencyStats;
+static FecReceiver fec;
+static SubscriptionAnnouncer subscription(
+  categoryBit(MessageCategory::SAI) | categoryBit(MessageCategory::Attitude) | categoryBit(MessageCategory::Integer) |
+    categoryBit(MessageCategory::Trend) | categoryBit(MessageCategory::Parity),
+  valueBit(ValueName::InstrumentLighting));
 
-    const MessageHeader* hdr = reinterpret_cast<const MessageHeader*>(data);
-    if (hdr->category ==  MessageCategory::SAI) {
-      portENTER_CRITICAL_ISR(&msgMux);
-      lastMessage = *reinterpret_cast<const SaiMessage *>(data);
-      portEXIT_CRITICAL_ISR(&msgMux);
-      hasNewMessage = true;
+static void onSai(const SaiMessage& message) {
+  const uint32_t now = millis();
+  portENTER_CRITICAL_ISR(&msgMux);
+  lastMessage = message;
+  bank.onValue(message.bank, now);
+  pitch.onValue(message.pitch, now);
+  slipBall.onValue(message.slipBall, now);
+  rateOfTurn.onValue(message.rateOfTurn, now);
+  portEXIT_CRITICAL_ISR(&msgMux);
+  hasNewMessage = true;
+}
+
+static void onMessage(const uint8_t* data, int len) {
+  const MessageHeader* hdr = reinterpret_cast<const MessageHeader*>(data);
+  if (hdr->category ==  MessageCategory::SAI && len == (int)sizeof(SaiMessage)) {
+    saiBase = *reinterpret_cast<const SaiMessage *>(data);
+    onSai(saiBase);
+  }
+  // Deltas against a base that was lost are dropped, the next resync brings it
+  if (hdr->category == MessageCategory::Attitude && len == (int)sizeof(AttitudeMessage)) {
+    SaiMessage message;
+    if (decodeAttitude(*reinterpret_cast<const AttitudeMessage *>(data), saiBase, message)) {
+      onSai(message);
     }
-    if (hdr->category == MessageCategory::Integer) {
-      IntegerMessage message = *reinterpret_cast<const IntegerMessage *>(data);
-      if (message.name == ValueName::InstrumentLighting) {
-        brightness = message.value;
-        hasNewMessage = true;
+  }
+  if (hdr->category == MessageCategory::Trend) {
+    portENTER_CRITICAL_ISR(&msgMux);
+    forEachTrend(data, len, [](TrendField field, int16_t rate) {
+      switch (field) {
+      case TrendField::SaiBank: bank.onRate(rate); break;
+      case TrendField::SaiPitch: pitch.onRate(rate); break;
+      case TrendField::SaiSlipBall: slipBall.onRate(rate); break;
+      case TrendField::SaiRateOfTurn: rateOfTurn.onRate(rate); break;
+      default: break;
       }
+    });
+    portEXIT_CRITICAL_ISR(&msgMux);
+  }
+  if (hdr->category == MessageCategory::Integer) {
+    IntegerMessage message = *reinterpret_cast<const IntegerMessage *>(data);
+    if (message.name == ValueName::InstrumentLighting) {
+      brightness = message.value;
+      hasNewMessage = true;
+    }
+  }
+}
+
+static void initTransport() {
+  if (!Transport::begin()) {
+    Serial.println("Transport init failed");
+    return;
+  }
+
+  Transport::onReceive([](const uint8_t* mac, const uint8_t* data, int len) {
+    latencyStats.recordFrame(data, len);
+    linkStats.recordFrame(data, len);
+    fec.recordFrame(data, len, onMessage);
+    forEachMessage(data, len, onMessage);
+    if (hasNewMessage) {
+      latencyStats.markPending();
     }
   });
+  subscription.begin();
+  latencyStats.begin();
 }
 
 void setup() {
@@ -48,16 +111,31 @@ void setup() {
   initRenderer();
   render(lastMessage);
 
-  initEspNowClient();
+  initTransport();
 }
 
 void loop() {
+  Transport::poll();
+  linkStats.serviceConsole(Serial, &latencyStats, &fec);
+  subscription.service(millis());
+  latencyStats.service(millis());
+
   const uint32_t now = millis();
 
+  // Up to 60 frames per second, the attitude stream and the trends keep it fed
   static uint32_t lastUpdatedAt = 0;
-  if (now - lastUpdatedAt > 40 && hasNewMessage) {
+  if (now - lastUpdatedAt >= 16 && (advanceTrends(now) || hasNewMessage)) {
     hasNewMessage = false;
     lastUpdatedAt = now;
-    render(lastMessage);
+
+    portENTER_CRITICAL(&msgMux);
+    SaiMessage message = lastMessage;
+    portEXIT_CRITICAL(&msgMux);
+    message.bank = bank.position;
+    message.pitch = pitch.position;
+    message.slipBall = slipBall.position;
+    message.rateOfTurn = rateOfTurn.position;
+    render(message);
+    latencyStats.displayed();
   }
 }
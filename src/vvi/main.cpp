@@ -5,11 +5,13 @@
 // Display_ST77916, esp_lcd_st77916, I2C_Driver files sourced from WaveShare's demo code for the display
 
 #include <Arduino.h>
-#include <WiFi.h>
-#include <esp_now.h>
 #include <lvgl.h>
 #include "Display_ST77916.h"
 #include "message.h"
+#include "transport.h"
+#include "link_stats.h"
+#include "subscription.h"
+#include "dead_reckoning.h"
 
 // LVGL bitmaps
 #include "verticleVelocityIndicator.c"
@@ -33,17 +35,32 @@ lv_obj_t *img_Needle;
 const int16_t center_x = DISP_WIDTH / 2;
 const int16_t center_y = DISP_HEIGHT / 2;
 
+static LatencyStats latencyStats;
+
 void my_disp_flush(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p) {
   LCD_addWindow(area->x1, area->y1, area->x2, area->y2, (uint16_t*)color_p);
   lv_disp_flush_ready(disp);
+  if (lv_disp_flush_is_last(disp)) {
+    latencyStats.displayed();
+  }
 }
 
-uint16_t vvi = 65535 / 2;
 uint16_t brightness = 0;
 bool dirty = true;
 
+// Fed by the receive callback (the WiFi task under ESP-NOW) and read by loop(), under msgMux
+static portMUX_TYPE msgMux = portMUX_INITIALIZER_UNLOCKED;
+static DeadReckoner vvi(65535 / 2);
+
+static bool advanceTrends(uint32_t now) {
+  portENTER_CRITICAL(&msgMux);
+  const bool moved = vvi.update(now);
+  portEXIT_CRITICAL(&msgMux);
+  return moved;
+}
+
 void updateRendering() {
-  int16_t angle = map(vvi, 0, 65535, 900, 4500);
+  int16_t angle = map(vvi.position, 0, 65535, 900, 4500);
   if (angle < 0) {
     angle -= 3600; // wrap around
   }
@@ -52,28 +69,53 @@ void updateRendering() {
   setBrightness(brightness);
 }
 
-static void initEspNowClient() {
-  WiFi.mode(WIFI_STA);
+static LinkStats linkStats;
+static SubscriptionAnnouncer subscription(
+  categoryBit(MessageCategory::Integer) | categoryBit(MessageCategory::Trend),
+  valueBit(ValueName::VerticalVelocityIndicator) | valueBit(ValueName::InstrumentLighting));
+
+static void onMessage(const uint8_t* data, int len) {
+  const MessageHeader* hdr = reinterpret_cast<const MessageHeader*>(data);
+  if (hdr->category == MessageCategory::Integer) {
+    IntegerMessage message = *reinterpret_cast<const IntegerMessage *>(data);
+    if (message.name == ValueName::VerticalVelocityIndicator) {
+      portENTER_CRITICAL_ISR(&msgMux);
+      vvi.onValue(message.value, millis());
+      portEXIT_CRITICAL_ISR(&msgMux);
+      dirty = true;
+    }
+    if (message.name == ValueName::InstrumentLighting) {
+      brightness = message.value;
+      dirty = true;
+    }
+  }
+  if (hdr->category == MessageCategory::Trend) {
+    forEachTrend(data, len, [](TrendField field, int16_t rate) {
+      if (field == TrendField::VerticalVelocityIndicator) {
+        portENTER_CRITICAL_ISR(&msgMux);
+        vvi.onRate(rate);
+        portEXIT_CRITICAL_ISR(&msgMux);
+      }
+    });
+  }
+}
 
-  if (esp_now_init() != ESP_OK) {
-    Serial.println("ESP-NOW init failed");
+static void initTransport() {
+  if (!Transport::begin()) {
+    Serial.println("Transport init failed");
     return;
   }
 
-  esp_now_register_recv_cb([](const esp_now_recv_info_t* info, const uint8_t* data, int len) {
-    const MessageHeader* hdr = reinterpret_cast<const MessageHeader*>(data);
-    if (hdr->category == MessageCategory::Integer) {
-      IntegerMessage message = *reinterpret_cast<const IntegerMessage *>(data);
-      if (message.name == ValueName::VerticalVelocityIndicator) {
-        vvi = message.value;
-        dirty = true;
-      }
-      if (message.name == ValueName::InstrumentLighting) {
-        brightness = message.value;
-        dirty = true;
-      }
+  Transport::onReceive([](const uint8_t* mac, const uint8_t* data, int len) {
+    latencyStats.recordFrame(data, len);
+    linkStats.recordFrame(data, len);
+    forEachMessage(data, len, onMessage);
+    if (dirty) {
+      latencyStats.markPending();
     }
   });
+  subscription.begin();
+  latencyStats.begin();
 }
 
 void setup() {
@@ -126,10 +168,15 @@ void setup() {
   // Align so the pivot is at the gauge center
   lv_obj_align(img_Needle, LV_ALIGN_CENTER, 0, 0);
 
-  initEspNowClient();
+  initTransport();
 }
 
 void loop() {
+  Transport::poll();
+  linkStats.serviceConsole(Serial, &latencyStats);
+  subscription.service(millis());
+  latencyStats.service(millis());
+
   static uint32_t lastTick = millis();
   const uint32_t now = millis();
   uint32_t dt = now - lastTick;
@@ -138,7 +185,7 @@ void loop() {
   lv_tick_inc(dt);
 
   static uint32_t lastUpdatedAt = 0;
-  if (now - lastUpdatedAt > 40 && dirty) {
+  if (now - lastUpdatedAt > 40 && (advanceTrends(now) || dirty)) {
     dirty = false;
     lastUpdatedAt = now;
     updateRendering();